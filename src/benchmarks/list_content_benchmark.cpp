@@ -0,0 +1,110 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+// Counts the heap allocations made while listing the contents of an SD card, to keep track of the
+// allocation behaviour of SDMCImporter::ListContent.
+// Usage: list_content_benchmark <SD card mount point> [iterations]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <fmt/format.h>
+#include "common/buffer_pool.h"
+#include "core/importer.h"
+
+namespace {
+std::atomic<u64> allocation_count{0};
+std::atomic<u64> allocation_size{0};
+
+void* CountedAllocate(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_size.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+} // namespace
+
+// Replace the global allocation functions, so that every allocation is counted, including those
+// of standard containers, strings and fmt. Aligned allocations (only made by the buffer pool)
+// are reported through the pool's stats instead.
+void* operator new(std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return CountedAllocate(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fmt::print(stderr, "Usage: {} <SD card mount point> [iterations]\n", argv[0]);
+        return 1;
+    }
+    const int iterations = argc >= 3 ? std::max(std::atoi(argv[2]), 1) : 5;
+
+    const auto configs = Core::LoadPresetConfig(argv[1]);
+    if (configs.empty()) {
+        fmt::print(stderr, "No preset config found at {}\n", argv[1]);
+        return 1;
+    }
+
+    Core::SDMCImporter importer(configs[0]);
+    if (!importer.IsGood()) {
+        fmt::print(stderr, "Failed to initialize the importer\n");
+        return 1;
+    }
+
+    // The first run also waits for the DBs that are loaded in the background, so it is reported
+    // separately as a warm-up.
+    for (int i = 0; i <= iterations; ++i) {
+        const auto pool_stats = Common::BufferPool::Get().GetStats();
+        const u64 start_count = allocation_count.load();
+        const u64 start_size = allocation_size.load();
+        const auto start_time = std::chrono::steady_clock::now();
+
+        std::size_t content_count = 0;
+        const std::atomic_bool cancelled{false};
+        importer.ListContent(
+            [&content_count](std::vector<Core::ContentSpecifier> batch) {
+                content_count += batch.size();
+            },
+            cancelled);
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                 std::chrono::steady_clock::now() - start_time)
+                                 .count();
+        const u64 count = allocation_count.load() - start_count;
+        const u64 size = allocation_size.load() - start_size;
+        const auto new_pool_stats = Common::BufferPool::Get().GetStats();
+
+        fmt::print("{} {}: {} contents in {} ms, {} allocations ({} bytes, {:.1f} per content), "
+                   "{} buffer pool requests ({} from the system)\n",
+                   i == 0 ? "Warm-up" : "Run", i, content_count, elapsed, count, size,
+                   content_count == 0 ? 0.0 : static_cast<double>(count) / content_count,
+                   new_pool_stats.requests - pool_stats.requests,
+                   new_pool_stats.system_allocations - pool_stats.system_allocations);
+    }
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstdint>
+#include "common/arena.h"
+
+namespace Common {
+
+Arena::Arena(std::size_t block_size_) : block_size(block_size_) {}
+
+Arena::~Arena() = default;
+
+void* Arena::Allocate(std::size_t size, std::size_t alignment) {
+    while (true) {
+        if (current_block < blocks.size()) {
+            auto& block = blocks[current_block];
+            const auto address = reinterpret_cast<std::uintptr_t>(block.data.get());
+            const auto offset = (address + current_offset + alignment - 1) / alignment * alignment -
+                                address;
+            if (offset + size <= block.size) {
+                current_offset = offset + size;
+                return block.data.get() + offset;
+            }
+            if (current_block + 1 < blocks.size()) {
+                current_block++;
+                current_offset = 0;
+                continue;
+            }
+        }
+
+        // Out of blocks, allocate one that is large enough for this allocation
+        const std::size_t new_size = std::max(block_size, size + alignment);
+        blocks.push_back({std::make_unique<std::byte[]>(new_size), new_size});
+        block_allocation_count++;
+        current_block = blocks.size() - 1;
+        current_offset = 0;
+    }
+}
+
+void Arena::Reset() {
+    current_block = 0;
+    current_offset = 0;
+}
+
+u64 Arena::GetBlockAllocationCount() const {
+    return block_allocation_count;
+}
+
+} // namespace Common
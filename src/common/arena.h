@@ -0,0 +1,101 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Monotonic arena for short-lived parsing objects, such as those created for each title when
+ * listing contents. Allocations are bumped out of blocks that are kept and reused after every
+ * Reset, so that the objects of one item are freed at once instead of one by one.
+ *
+ * Objects allocated from the arena must not outlive the next Reset. Not thread-safe.
+ */
+class Arena {
+public:
+    explicit Arena(std::size_t block_size = 16 * 1024);
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* Allocate(std::size_t size, std::size_t alignment);
+
+    /// Frees everything allocated since the last reset. The blocks are kept for reuse.
+    void Reset();
+
+    /// Gets the number of blocks allocated from the system.
+    u64 GetBlockAllocationCount() const;
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    std::size_t block_size;
+    std::vector<Block> blocks;
+    std::size_t current_block = 0;
+    std::size_t current_offset = 0;
+    u64 block_allocation_count = 0;
+};
+
+/**
+ * Allocator for containers of parsing objects. Allocates from an arena when given one, and from
+ * the heap otherwise. Copies of containers always use the heap, so that they may outlive the
+ * arena; moved containers keep the memory of their source.
+ */
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::false_type;
+    using propagate_on_container_move_assignment = std::false_type;
+    using propagate_on_container_swap = std::false_type;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(Arena* arena_) noexcept : arena(arena_) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+    T* allocate(std::size_t n) {
+        if (arena) {
+            return static_cast<T*>(arena->Allocate(n * sizeof(T), alignof(T)));
+        }
+        return std::allocator<T>{}.allocate(n);
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+        if (!arena) {
+            std::allocator<T>{}.deallocate(ptr, n);
+        }
+    }
+
+    ArenaAllocator select_on_container_copy_construction() const noexcept {
+        return {};
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept {
+        return arena == other.arena;
+    }
+
+private:
+    template <typename U>
+    friend class ArenaAllocator;
+
+    Arena* arena = nullptr;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+} // namespace Common
@@ -0,0 +1,156 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include "common/buffer_pool.h"
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace Common {
+
+namespace {
+// Aligned operator new is not available before macOS 10.14, so use the platform functions
+void* AllocateAligned(std::size_t size, std::size_t alignment) {
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size, alignment);
+#else
+    void* ptr = nullptr;
+    if (posix_memalign(&ptr, alignment, size) != 0) {
+        ptr = nullptr;
+    }
+#endif
+    if (!ptr) {
+        throw std::bad_alloc{};
+    }
+    return ptr;
+}
+
+void FreeAligned(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+} // namespace
+
+BufferPool& BufferPool::Get() {
+    // Never destroyed, as pooled containers may still be freed during static destruction
+    static BufferPool* pool = new BufferPool;
+    return *pool;
+}
+
+BufferPool::BufferPool() = default;
+
+std::size_t BufferPool::GetClass(std::size_t size) {
+    if (size <= MinClassSize) {
+        return 0;
+    }
+    const auto index = static_cast<std::size_t>(std::bit_width(size - 1)) -
+                       static_cast<std::size_t>(std::bit_width(MinClassSize - 1));
+    return std::min(index, ClassCount);
+}
+
+std::size_t BufferPool::GetAllocationSize(std::size_t size) {
+    const auto index = GetClass(size);
+    if (index == ClassCount) {
+        return (size + PageSize - 1) / PageSize * PageSize;
+    }
+    return MinClassSize << index;
+}
+
+std::size_t BufferPool::GetAlignment(std::size_t allocation_size) {
+    // Large buffers are always aligned to huge pages, so that the setting may change at any time
+    return allocation_size >= HugePageSize ? HugePageSize : PageSize;
+}
+
+void* BufferPool::Allocate(std::size_t size) {
+    const auto index = GetClass(size);
+    const auto allocation_size = GetAllocationSize(size);
+
+    bool use_huge_pages;
+    {
+        std::lock_guard lock{mutex};
+        stats.requests++;
+        stats.in_use_size += allocation_size;
+        if (index < ClassCount && !free_lists[index].empty()) {
+            void* ptr = free_lists[index].back();
+            free_lists[index].pop_back();
+            stats.cached_size -= allocation_size;
+            return ptr;
+        }
+        stats.system_allocations++;
+        use_huge_pages = huge_pages;
+    }
+
+    void* ptr = AllocateAligned(allocation_size, GetAlignment(allocation_size));
+#ifdef MADV_HUGEPAGE
+    if (use_huge_pages && allocation_size >= HugePageSize) {
+        madvise(ptr, allocation_size, MADV_HUGEPAGE);
+    }
+#else
+    (void)use_huge_pages;
+#endif
+    return ptr;
+}
+
+void BufferPool::Deallocate(void* ptr, std::size_t size) {
+    if (!ptr) {
+        return;
+    }
+
+    const auto index = GetClass(size);
+    const auto allocation_size = GetAllocationSize(size);
+    {
+        std::lock_guard lock{mutex};
+        stats.in_use_size -= allocation_size;
+        if (index < ClassCount && stats.cached_size + allocation_size <= cache_limit) {
+            free_lists[index].push_back(ptr);
+            stats.cached_size += allocation_size;
+            return;
+        }
+    }
+    FreeAligned(ptr);
+}
+
+void BufferPool::SetCacheLimit(std::size_t size) {
+    {
+        std::lock_guard lock{mutex};
+        cache_limit = size;
+    }
+    Trim();
+}
+
+void BufferPool::SetHugePages(bool enabled) {
+    std::lock_guard lock{mutex};
+    huge_pages = enabled;
+}
+
+void BufferPool::Trim() {
+    std::array<std::vector<void*>, ClassCount> lists;
+    {
+        std::lock_guard lock{mutex};
+        lists.swap(free_lists);
+        stats.cached_size = 0;
+    }
+    for (const auto& list : lists) {
+        for (void* ptr : list) {
+            FreeAligned(ptr);
+        }
+    }
+}
+
+BufferPool::Stats BufferPool::GetStats() const {
+    std::lock_guard lock{mutex};
+    return stats;
+}
+
+} // namespace Common
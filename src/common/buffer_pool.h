@@ -0,0 +1,120 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Process-wide pool of page-aligned buffers for file data, so that the buffers of decryption
+ * and container parsing are reused instead of being allocated for every file or chunk.
+ *
+ * Buffers are grouped in power-of-two size classes. Freed buffers are kept for reuse up to a
+ * total size, and larger requests are served by the system directly.
+ */
+class BufferPool {
+public:
+    static constexpr std::size_t PageSize = 4096;
+    static constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+    struct Stats {
+        u64 requests;           ///< Number of buffers requested
+        u64 system_allocations; ///< Number of requests that had to allocate from the system
+        u64 in_use_size;        ///< Total size of the buffers in use
+        u64 cached_size;        ///< Total size of the freed buffers kept for reuse
+    };
+
+    static BufferPool& Get();
+
+    /// Gets a page-aligned buffer of at least `size` bytes.
+    void* Allocate(std::size_t size);
+
+    /// Returns a buffer. `size` must be the size it was requested with.
+    void Deallocate(void* ptr, std::size_t size);
+
+    /// Sets the maximum total size of the freed buffers kept for reuse.
+    void SetCacheLimit(std::size_t size);
+
+    /**
+     * Sets whether buffers of at least a huge page are backed by transparent huge pages (Linux
+     * only), reducing TLB misses when processing large chunks. Applies to buffers allocated
+     * afterwards.
+     */
+    void SetHugePages(bool enabled);
+
+    /// Frees all the buffers kept for reuse.
+    void Trim();
+
+    Stats GetStats() const;
+
+private:
+    static constexpr std::size_t MinClassSize = PageSize;
+    static constexpr std::size_t ClassCount = 15; // Up to 64 MB
+
+    BufferPool();
+
+    /// Gets the size class for a size, or ClassCount if it is too large to be pooled.
+    static std::size_t GetClass(std::size_t size);
+    static std::size_t GetAllocationSize(std::size_t size);
+    static std::size_t GetAlignment(std::size_t allocation_size);
+
+    mutable std::mutex mutex;
+    std::array<std::vector<void*>, ClassCount> free_lists;
+    std::size_t cache_limit = 256 * 1024 * 1024;
+    bool huge_pages = false;
+    Stats stats{};
+};
+
+/**
+ * Allocator using the buffer pool, for containers of file data.
+ * Elements are default-initialized, so resizing does not clear memory that is about to be
+ * overwritten anyway.
+ */
+template <typename T>
+class PoolAllocator {
+public:
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(BufferPool::Get().Allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) noexcept {
+        BufferPool::Get().Deallocate(ptr, n * sizeof(T));
+    }
+
+    template <typename U, typename... Args>
+    void construct(U* ptr, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) {
+            ::new (static_cast<void*>(ptr)) U;
+        } else {
+            ::new (static_cast<void*>(ptr)) U(std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>&) const noexcept {
+        return true;
+    }
+};
+
+template <typename T>
+using PooledVector = std::vector<T, PoolAllocator<T>>;
+
+/// A buffer of file data using pooled memory.
+using PooledBuffer = PooledVector<u8>;
+
+} // namespace Common
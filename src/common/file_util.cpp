@@ -31,6 +31,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <dirent.h>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
 #endif
@@ -878,6 +879,8 @@ IOFile::IOFile(const std::string& filename, const char openmode[], int flags) {
     Open(filename, openmode, flags);
 }
 
+IOFile::IOFile(std::FILE* file) : m_file(file), m_good(file != nullptr) {}
+
 IOFile::~IOFile() {
     Close();
 }
@@ -934,25 +937,6 @@ std::size_t IOFile::Write(const char* data, std::size_t length) {
     return items_written;
 }
 
-std::vector<u8> IOFile::GetData() {
-    if (!IsOpen()) {
-        m_good = false;
-        LOG_ERROR(Common, "File is not open");
-        return {};
-    }
-    if (!Seek(0, SEEK_SET)) {
-        LOG_ERROR(Common, "Failed to seek file");
-        return {};
-    }
-
-    std::vector<u8> data(GetSize());
-    if (Read(reinterpret_cast<char*>(data.data()), data.size()) != data.size()) {
-        LOG_ERROR(Common, "Failed to read from file");
-        return {};
-    }
-    return data;
-}
-
 u64 IOFile::GetSize() const {
     if (IsOpen())
         return FileUtil::GetSize(m_file);
@@ -982,6 +966,98 @@ bool IOFile::Flush() {
     return m_good;
 }
 
+bool IOFile::Preallocate(u64 size) {
+    if (!IsOpen() || size == 0) {
+        return false;
+    }
+
+    // Failures are not errors (m_good is kept), as this is only an optimization
+    const u64 offset = Tell();
+#if defined(_WIN32)
+    // Windows can only preallocate from the start of the file, which is what matters anyway.
+    // Setting a smaller allocation size would truncate the reservation, so only grow it.
+    const auto handle = reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(m_file)));
+    FILE_STANDARD_INFO standard_info{};
+    if (!GetFileInformationByHandleEx(handle, FileStandardInfo, &standard_info,
+                                      sizeof(standard_info))) {
+        return false;
+    }
+    const auto allocation_size = static_cast<LONGLONG>(offset + size);
+    if (standard_info.AllocationSize.QuadPart >= allocation_size) {
+        return true;
+    }
+    FILE_ALLOCATION_INFO info{};
+    info.AllocationSize.QuadPart = allocation_size;
+    return SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info)) != 0;
+#elif defined(__linux__)
+    // Keep the size, so that the file ends where the data does, even if fewer bytes are written
+    return fallocate(fileno(m_file), FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+                     static_cast<off_t>(size)) == 0;
+#elif defined(__APPLE__)
+    // F_PREALLOCATE allocates relative to the physical end of the file
+    const u64 file_size = GetSize();
+    if (offset + size <= file_size) {
+        return true;
+    }
+    fstore_t store{F_ALLOCATECONTIG, F_PEOFPOSMODE, 0,
+                   static_cast<off_t>(offset + size - file_size), 0};
+    if (fcntl(fileno(m_file), F_PREALLOCATE, &store) != -1) {
+        return true;
+    }
+    store.fst_flags = F_ALLOCATEALL; // Contiguous space not available, try again without it
+    return fcntl(fileno(m_file), F_PREALLOCATE, &store) != -1;
+#else
+    return false;
+#endif
+}
+
+void IOFile::Advise([[maybe_unused]] s64 offset, [[maybe_unused]] u64 length,
+                    [[maybe_unused]] CacheAdvice advice) {
+#ifdef POSIX_FADV_DONTNEED
+    if (!IsOpen()) {
+        return;
+    }
+    const s64 start = static_cast<s64>(Tell()) + offset;
+    if (start < 0) {
+        return;
+    }
+
+    int posix_advice{};
+    switch (advice) {
+    case CacheAdvice::Sequential:
+        posix_advice = POSIX_FADV_SEQUENTIAL;
+        break;
+    case CacheAdvice::WillNeed:
+        posix_advice = POSIX_FADV_WILLNEED;
+        break;
+    case CacheAdvice::DontNeed:
+        posix_advice = POSIX_FADV_DONTNEED;
+        break;
+    }
+    posix_fadvise(fileno(m_file), static_cast<off_t>(start), static_cast<off_t>(length),
+                  posix_advice);
+#endif
+}
+
+void IOFile::Writeback([[maybe_unused]] s64 offset, [[maybe_unused]] u64 length,
+                       [[maybe_unused]] bool wait) {
+#ifdef __linux__
+    // Data may still be buffered by stdio
+    if (!IsOpen() || std::fflush(m_file) != 0) {
+        return;
+    }
+    const s64 start = static_cast<s64>(Tell()) + offset;
+    if (start < 0) {
+        return;
+    }
+
+    const unsigned int flags =
+        wait ? (SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER)
+             : SYNC_FILE_RANGE_WRITE;
+    sync_file_range(fileno(m_file), static_cast<off_t>(start), static_cast<off_t>(length), flags);
+#endif
+}
+
 bool IOFile::Resize(u64 size) {
     if (!IsOpen() || 0 !=
 #ifdef _WIN32
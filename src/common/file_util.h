@@ -180,6 +180,13 @@ void SplitFilename83(const std::string& filename, std::array<char, 9>& short_nam
 // and make forgetting an fclose() harder
 class IOFile : public NonCopyable {
 public:
+    /// Page cache hints for IOFile::Advise.
+    enum class CacheAdvice {
+        Sequential, ///< The range will be accessed sequentially
+        WillNeed,   ///< The range will be accessed soon, so read it ahead
+        DontNeed,   ///< The range will not be accessed again, so drop it from the cache
+    };
+
     IOFile();
 
     // flags is used for windows specific file open mode flags, which
@@ -187,6 +194,9 @@ public:
     // isn't considered "locked" while citra is open and people can open the log file and view it
     IOFile(const std::string& filename, const char openmode[], int flags = 0);
 
+    /// Takes ownership of an already open stream, such as stdout. It is closed on destruction.
+    explicit IOFile(std::FILE* file);
+
     virtual ~IOFile();
 
     bool Open(const std::string& filename, const char openmode[], int flags = 0);
@@ -229,9 +239,32 @@ public:
     virtual std::size_t Read(char* data, std::size_t length);
     virtual std::size_t Write(const char* data, std::size_t length);
 
-    std::vector<u8> GetData();
+    /**
+     * Reads the whole file.
+     * @tparam Container Container of u8 to read into, e.g. Common::PooledBuffer for pooled memory
+     * @return The data, or an empty container on failure
+     */
+    template <typename Container = std::vector<u8>>
+    Container GetData() {
+        if (!IsOpen()) {
+            m_good = false;
+            LOG_ERROR(Common, "File is not open");
+            return {};
+        }
+        if (!Seek(0, SEEK_SET)) {
+            LOG_ERROR(Common, "Failed to seek file");
+            return {};
+        }
+
+        Container data(GetSize());
+        if (Read(reinterpret_cast<char*>(data.data()), data.size()) != data.size()) {
+            LOG_ERROR(Common, "Failed to read from file");
+            return {};
+        }
+        return data;
+    }
 
-    bool IsOpen() const {
+    virtual bool IsOpen() const {
         return nullptr != m_file;
     }
 
@@ -244,11 +277,33 @@ public:
     }
 
     virtual bool Seek(s64 off, int origin);
-    u64 Tell() const;
-    u64 GetSize() const;
+    virtual u64 Tell() const;
+    virtual u64 GetSize() const;
     bool Resize(u64 size);
     bool Flush();
 
+    /**
+     * Reserves disk space for `size` more bytes to be written from the current position, to
+     * reduce fragmentation. The file size is not changed where possible.
+     * @return true on success, false if unsupported by the platform or the file system, which
+     *         is not an error.
+     */
+    virtual bool Preallocate(u64 size);
+
+    /**
+     * Hints the OS on how a range of the file will be accessed, to manage the page cache.
+     * The offset is relative to the current position, so negative offsets refer to data that
+     * has already been read or written. No-op where unsupported.
+     */
+    virtual void Advise(s64 offset, u64 length, CacheAdvice advice);
+
+    /**
+     * Writes a range of the file back to disk (Linux only), so that it can be dropped from the
+     * page cache afterwards. The offset is relative to the current position.
+     * @param wait Whether to wait for the writeback to complete, or only start it.
+     */
+    virtual void Writeback(s64 offset, u64 length, bool wait);
+
     // clear error state
     void Clear() {
         m_good = true;
@@ -272,6 +327,7 @@ bool WriteBytesToFile(const std::string& path, T* data, std::size_t length) {
         LOG_ERROR(Core, "Could not open file {}", path);
         return false;
     }
+    file.Preallocate(length);
     if (file.WriteBytes(data, length) != length) {
         LOG_ERROR(Core, "Write data failed (file: {})", path);
         return false;
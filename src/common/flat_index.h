@@ -0,0 +1,181 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Compact open-addressing hash index from 64-bit IDs (e.g. title IDs) to 32-bit values, which
+ * are usually indices or offsets into a contiguous storage owned by the user.
+ * Uses linear probing over a single power-of-two sized slot array.
+ */
+class FlatIndex {
+public:
+    static constexpr u32 InvalidValue = 0xFFFFFFFF;
+
+    /// Makes sure that `count` entries can be inserted without rehashing.
+    void Reserve(std::size_t count) {
+        std::size_t capacity = 16;
+        while (capacity / 2 < count) { // Keep load factor <= 0.5
+            capacity *= 2;
+        }
+        if (capacity > slots.size()) {
+            Rehash(capacity);
+        }
+    }
+
+    /**
+     * Inserts a key. Does nothing if the key already exists.
+     * @return true if the key has been inserted, false if it already exists
+     */
+    bool Insert(u64 key, u32 value) {
+        Reserve(size + 1);
+
+        Slot& slot = FindSlot(key);
+        if (slot.value != InvalidValue) {
+            return false;
+        }
+        slot = {key, value};
+        size++;
+        return true;
+    }
+
+    /// Returns the value of a key, or InvalidValue if it does not exist.
+    u32 Find(u64 key) const {
+        if (slots.empty()) {
+            return InvalidValue;
+        }
+        return const_cast<FlatIndex*>(this)->FindSlot(key).value;
+    }
+
+    bool Contains(u64 key) const {
+        return Find(key) != InvalidValue;
+    }
+
+    std::size_t Size() const {
+        return size;
+    }
+
+    void Clear() {
+        slots.clear();
+        size = 0;
+    }
+
+private:
+    struct Slot {
+        u64 key;
+        u32 value = InvalidValue;
+    };
+
+    static u64 Hash(u64 key) {
+        // splitmix64 finalizer. Title IDs differ mostly in the middle bits.
+        key = (key ^ (key >> 30)) * 0xBF58476D1CE4E5B9;
+        key = (key ^ (key >> 27)) * 0x94D049BB133111EB;
+        return key ^ (key >> 31);
+    }
+
+    /// Returns the slot holding the key, or the empty slot where it should be inserted.
+    Slot& FindSlot(u64 key) {
+        const std::size_t mask = slots.size() - 1;
+        std::size_t pos = Hash(key) & mask;
+        while (slots[pos].value != InvalidValue && slots[pos].key != key) {
+            pos = (pos + 1) & mask;
+        }
+        return slots[pos];
+    }
+
+    void Rehash(std::size_t capacity) {
+        std::vector<Slot> old_slots(capacity);
+        std::swap(slots, old_slots);
+        for (const auto& slot : old_slots) {
+            if (slot.value != InvalidValue) {
+                FindSlot(slot.key) = slot;
+            }
+        }
+    }
+
+    std::vector<Slot> slots;
+    std::size_t size = 0;
+};
+
+/**
+ * Map from 64-bit IDs to values, with all values stored contiguously in insertion order and
+ * looked up through a FlatIndex. Entries cannot be erased individually.
+ * Provides the subset of the std::unordered_map interface used throughout the code.
+ */
+template <typename T>
+class FlatMap {
+public:
+    using value_type = std::pair<u64, T>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+    void reserve(std::size_t count) {
+        entries.reserve(count);
+        index.Reserve(count);
+    }
+
+    /// Like std::unordered_map::emplace, does nothing if the key already exists.
+    template <typename... Args>
+    bool emplace(u64 key, Args&&... args) {
+        if (!index.Insert(key, static_cast<u32>(entries.size()))) {
+            return false;
+        }
+        entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key),
+                             std::forward_as_tuple(std::forward<Args>(args)...));
+        return true;
+    }
+
+    std::size_t count(u64 key) const {
+        return index.Contains(key) ? 1 : 0;
+    }
+
+    /// Returns a pointer to the value of a key, or nullptr if it does not exist.
+    const T* find(u64 key) const {
+        const u32 pos = index.Find(key);
+        return pos == FlatIndex::InvalidValue ? nullptr : &entries[pos].second;
+    }
+
+    const T& at(u64 key) const {
+        const T* value = find(key);
+        if (!value) {
+            throw std::out_of_range("FlatMap::at");
+        }
+        return *value;
+    }
+
+    std::size_t size() const {
+        return entries.size();
+    }
+
+    bool empty() const {
+        return entries.empty();
+    }
+
+    void clear() {
+        entries.clear();
+        index.Clear();
+    }
+
+    const_iterator begin() const {
+        return entries.begin();
+    }
+
+    const_iterator end() const {
+        return entries.end();
+    }
+
+private:
+    std::vector<value_type> entries;
+    FlatIndex index;
+};
+
+} // namespace Common
@@ -0,0 +1,97 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <utility>
+#include "common/memory_budget.h"
+
+namespace Common {
+
+MemoryBudget::Reservation::Reservation(u64 size_) : size(size_) {}
+
+MemoryBudget::Reservation::~Reservation() {
+    Release();
+}
+
+MemoryBudget::Reservation::Reservation(Reservation&& other) noexcept
+    : size(std::exchange(other.size, 0)) {}
+
+MemoryBudget::Reservation& MemoryBudget::Reservation::operator=(Reservation&& other) noexcept {
+    if (this != &other) {
+        Release();
+        size = std::exchange(other.size, 0);
+    }
+    return *this;
+}
+
+u64 MemoryBudget::Reservation::GetSize() const {
+    return size;
+}
+
+void MemoryBudget::Reservation::Release() {
+    if (size != 0) {
+        MemoryBudget::Get().Free(std::exchange(size, 0));
+    }
+}
+
+MemoryBudget& MemoryBudget::Get() {
+    static MemoryBudget budget;
+    return budget;
+}
+
+MemoryBudget::MemoryBudget() = default;
+
+void MemoryBudget::SetLimit(u64 bytes) {
+    {
+        std::lock_guard lock{mutex};
+        limit = bytes;
+    }
+    budget_changed.notify_all();
+}
+
+u64 MemoryBudget::GetLimit() const {
+    std::lock_guard lock{mutex};
+    return limit;
+}
+
+bool MemoryBudget::Fits(u64 size) const {
+    return limit == 0 || usage == 0 || usage + size <= limit;
+}
+
+MemoryBudget::Reservation MemoryBudget::Reserve(u64 size) {
+    if (size == 0) {
+        return {};
+    }
+
+    std::unique_lock lock{mutex};
+    budget_changed.wait(lock, [this, size] { return Fits(size); });
+    usage += size;
+    peak_usage = std::max(peak_usage, usage);
+    return Reservation{size};
+}
+
+void MemoryBudget::Free(u64 size) {
+    {
+        std::lock_guard lock{mutex};
+        usage -= size;
+    }
+    budget_changed.notify_all();
+}
+
+u64 MemoryBudget::GetUsage() const {
+    std::lock_guard lock{mutex};
+    return usage;
+}
+
+u64 MemoryBudget::GetPeakUsage() const {
+    std::lock_guard lock{mutex};
+    return peak_usage;
+}
+
+void MemoryBudget::ResetPeakUsage() {
+    std::lock_guard lock{mutex};
+    peak_usage = usage;
+}
+
+} // namespace Common
@@ -0,0 +1,87 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Process-wide budget for the large buffers of operations that hold whole files in memory
+ * (e.g. savegames and extdata, which are unwrapped in memory), so that concurrent operations
+ * cannot exhaust the RAM of the machine. Streaming operations do not need to take part.
+ *
+ * An operation reserves its estimated peak usage once before allocating, and keeps the
+ * reservation until the buffers are freed. To avoid deadlocks, a thread must not wait for a
+ * reservation while holding another one.
+ */
+class MemoryBudget {
+public:
+    /// A reservation of memory in the budget, returned to it on destruction.
+    class Reservation {
+    public:
+        Reservation() = default;
+        ~Reservation();
+
+        Reservation(Reservation&& other) noexcept;
+        Reservation& operator=(Reservation&& other) noexcept;
+
+        Reservation(const Reservation&) = delete;
+        Reservation& operator=(const Reservation&) = delete;
+
+        u64 GetSize() const;
+
+        /// Returns the memory to the budget early.
+        void Release();
+
+    private:
+        friend class MemoryBudget;
+        explicit Reservation(u64 size);
+
+        u64 size = 0;
+    };
+
+    static MemoryBudget& Get();
+
+    /**
+     * Sets the maximum amount of memory that may be reserved at the same time. Takes effect
+     * immediately, even for reservations already waiting.
+     * @param bytes 0 for unlimited
+     */
+    void SetLimit(u64 bytes);
+    u64 GetLimit() const;
+
+    /**
+     * Blocks until `size` bytes fit in the budget. A reservation larger than the whole budget
+     * is granted once nothing else is reserved, i.e. such operations are run one at a time.
+     */
+    Reservation Reserve(u64 size);
+
+    /// Gets the amount of memory currently reserved.
+    u64 GetUsage() const;
+
+    /// Gets the highest amount of memory reserved at the same time since the last reset.
+    u64 GetPeakUsage() const;
+    void ResetPeakUsage();
+
+private:
+    MemoryBudget();
+
+    /// Whether `size` bytes can be reserved now. mutex must be held.
+    bool Fits(u64 size) const;
+
+    void Free(u64 size);
+
+    mutable std::mutex mutex;
+    std::condition_variable budget_changed;
+
+    u64 limit = 0;
+    u64 usage = 0;
+    u64 peak_usage = 0;
+};
+
+} // namespace Common
@@ -0,0 +1,109 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <thread>
+#include "common/resource_governor.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#elif defined(__linux__)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Common {
+
+ResourceGovernor& ResourceGovernor::Get() {
+    static ResourceGovernor governor;
+    return governor;
+}
+
+ResourceGovernor::ResourceGovernor() : last_refill(std::chrono::steady_clock::now()) {}
+
+void ResourceGovernor::SetRateLimit(u64 bytes_per_second) {
+    {
+        std::lock_guard lock{mutex};
+        Refill();
+        rate_limit = bytes_per_second;
+        // Start over, so that debts under the previous limit are not carried over
+        tokens = 0;
+    }
+    rate_changed.notify_all();
+}
+
+u64 ResourceGovernor::GetRateLimit() const {
+    std::lock_guard lock{mutex};
+    return rate_limit;
+}
+
+void ResourceGovernor::Acquire(u64 size) {
+    std::unique_lock lock{mutex};
+    while (rate_limit != 0) {
+        Refill();
+        // A transfer may go into debt, which the following ones then wait for
+        if (tokens >= 0) {
+            tokens -= static_cast<double>(size);
+            return;
+        }
+        const std::chrono::duration<double> wait{-tokens / static_cast<double>(rate_limit)};
+        rate_changed.wait_for(lock, wait);
+    }
+}
+
+void ResourceGovernor::Refill() {
+    const auto now = std::chrono::steady_clock::now();
+    const std::chrono::duration<double> elapsed = now - last_refill;
+    last_refill = now;
+
+    // Allow bursts of up to a second's worth of transfers
+    const auto rate = static_cast<double>(rate_limit);
+    tokens = std::min(tokens + elapsed.count() * rate, rate);
+}
+
+void ResourceGovernor::SetMaxThreads(std::size_t count) {
+    std::lock_guard lock{mutex};
+    max_threads = count;
+}
+
+std::size_t ResourceGovernor::GetMaxThreads() const {
+    const std::size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::lock_guard lock{mutex};
+    return max_threads == 0 ? hardware_threads : std::min(max_threads, hardware_threads);
+}
+
+void ResourceGovernor::SetLowPriority(bool enabled) {
+    std::lock_guard lock{mutex};
+    low_priority = enabled;
+}
+
+bool ResourceGovernor::IsLowPriority() const {
+    std::lock_guard lock{mutex};
+    return low_priority;
+}
+
+void ResourceGovernor::ApplyThreadPriority() const {
+    if (!IsLowPriority()) {
+        return;
+    }
+
+#ifdef _WIN32
+    // Lowers both the CPU and the I/O priority
+    SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#elif defined(__linux__)
+    // On Linux, both are per-thread attributes
+    const auto tid = static_cast<id_t>(syscall(SYS_gettid));
+    setpriority(PRIO_PROCESS, tid, 10);
+
+    constexpr int IOPRIO_WHO_PROCESS = 1;
+    constexpr int IOPRIO_CLASS_BE = 2;
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, static_cast<int>(tid),
+            (IOPRIO_CLASS_BE << IOPRIO_CLASS_SHIFT) | 7); // Lowest priority of the default class
+#endif
+}
+
+} // namespace Common
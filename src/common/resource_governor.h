@@ -0,0 +1,72 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Process-wide limits on the resources used by import work, so that it does not starve other
+ * programs on the same machine. Every setting may be changed at any time from any thread,
+ * including while a job is running.
+ */
+class ResourceGovernor {
+public:
+    static ResourceGovernor& Get();
+
+    /**
+     * Sets the maximum I/O rate (bytes read plus bytes written per second), enforced with a
+     * token bucket. Takes effect immediately, even for transfers already waiting.
+     * @param bytes_per_second 0 for unlimited
+     */
+    void SetRateLimit(u64 bytes_per_second);
+    u64 GetRateLimit() const;
+
+    /// Blocks until `size` bytes may be transferred under the rate limit.
+    void Acquire(u64 size);
+
+    /**
+     * Sets the maximum number of threads used for parallel work. Applies to work started
+     * afterwards.
+     * @param count 0 for the hardware concurrency
+     */
+    void SetMaxThreads(std::size_t count);
+
+    /// Gets the maximum number of threads to use, taking the hardware concurrency into account.
+    std::size_t GetMaxThreads() const;
+
+    /**
+     * Sets whether worker threads run at a low CPU and I/O priority (nice and ioprio on Linux,
+     * background mode on Windows). Applies to worker threads started afterwards.
+     */
+    void SetLowPriority(bool enabled);
+    bool IsLowPriority() const;
+
+    /// Applies the priority settings to the calling thread. Called when worker threads start.
+    void ApplyThreadPriority() const;
+
+private:
+    ResourceGovernor();
+
+    /// Adds the tokens accumulated since the last refill. mutex must be held.
+    void Refill();
+
+    mutable std::mutex mutex;
+    std::condition_variable rate_changed;
+
+    u64 rate_limit = 0;
+    double tokens = 0; ///< May be negative, when a transfer is larger than what was available
+    std::chrono::steady_clock::time_point last_refill;
+
+    std::size_t max_threads = 0;
+    bool low_priority = false;
+};
+
+} // namespace Common
@@ -5,11 +5,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
 #include <cstddef>
 #include <mutex>
 #include <thread>
+#include <vector>
+#include "common/resource_governor.h"
 
 namespace Common {
 
@@ -92,4 +96,45 @@ private:
     std::size_t generation = 0; // Incremented once each time the barrier is used
 };
 
+/**
+ * Calls func(i) for every i in [0, count) on a number of worker threads (including the calling
+ * thread), and blocks until all of them are done. Indices are handed out one at a time, so
+ * func may take varying time for different indices.
+ * @param max_threads Maximum number of threads to use. 0 for the limit of the ResourceGovernor
+ *                    (by default the hardware concurrency).
+ */
+template <typename Func>
+void ParallelFor(std::size_t count, Func&& func, std::size_t max_threads = 0) {
+    if (max_threads == 0) {
+        max_threads = ResourceGovernor::Get().GetMaxThreads();
+    }
+    const std::size_t thread_count = std::min(count, max_threads);
+    if (thread_count <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+
+    std::atomic<std::size_t> next{0};
+    const auto worker = [&] {
+        for (std::size_t i = next++; i < count; i = next++) {
+            func(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (std::size_t i = 1; i < thread_count; ++i) {
+        threads.emplace_back([&worker] {
+            ResourceGovernor::Get().ApplyThreadPriority();
+            worker();
+        });
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
 } // namespace Common
@@ -2,10 +2,17 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <atomic>
+#ifdef _WIN32
+#include <share.h> // For _SH_DENYNO
+#endif
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/sha.h>
 #include "common/alignment.h"
+#include "common/resource_governor.h"
+#include "common/thread.h"
 #include "core/cia_builder.h"
 #include "core/db/title_db.h"
 #include "core/db/title_keys_bin.h"
@@ -14,10 +21,16 @@
 #include "core/file_sys/ticket.h"
 #include "core/file_sys/title_metadata.h"
 #include "core/importer.h"
+#include "core/tee_file.h"
 
 namespace Core {
 
-constexpr std::size_t CIA_ALIGNMENT = 0x40;
+#ifdef _WIN32
+// The CIA is written through several handles at once in AddContents
+constexpr int CIAShareFlags = _SH_DENYNO;
+#else
+constexpr int CIAShareFlags = 0;
+#endif
 
 class HashedFile : public FileUtil::IOFile {
 public:
@@ -53,6 +66,61 @@ private:
     bool hash_enabled{};
 };
 
+/// In-memory file, used to assemble the beginning of a CIA when building sequentially.
+class MemoryFile : public FileUtil::IOFile {
+public:
+    explicit MemoryFile() = default;
+    ~MemoryFile() override = default;
+
+    std::size_t Write(const char* data_, std::size_t length) override {
+        if (data.size() < position + length) {
+            data.resize(position + length);
+        }
+        std::memcpy(data.data() + position, data_, length);
+        position += length;
+        return length;
+    }
+
+    /// Seeking beyond the end extends the file with zeros.
+    bool Seek(s64 off, int origin) override {
+        s64 new_position = off;
+        if (origin == SEEK_CUR) {
+            new_position += static_cast<s64>(position);
+        } else if (origin == SEEK_END) {
+            new_position += static_cast<s64>(data.size());
+        }
+        if (new_position < 0) {
+            return false;
+        }
+
+        position = static_cast<std::size_t>(new_position);
+        if (data.size() < position) {
+            data.resize(position);
+        }
+        return true;
+    }
+
+    bool IsOpen() const override {
+        return true;
+    }
+
+    u64 Tell() const override {
+        return position;
+    }
+
+    u64 GetSize() const override {
+        return data.size();
+    }
+
+    const std::vector<u8>& GetBuffer() const {
+        return data;
+    }
+
+private:
+    std::vector<u8> data;
+    std::size_t position = 0;
+};
+
 CIABuilder::CIABuilder(const Config& config, std::shared_ptr<TicketDB> ticket_db_)
     : ticket_db(std::move(ticket_db_)) {
     if (!config.enc_title_keys_bin_path.empty()) {
@@ -66,18 +134,23 @@ CIABuilder::CIABuilder(const Config& config, std::shared_ptr<TicketDB> ticket_db
 
 CIABuilder::~CIABuilder() = default;
 
-bool CIABuilder::Init(CIABuildType type_, const std::string& destination, TitleMetadata tmd_,
+bool CIABuilder::Init(CIABuildType type_, const std::string& destination_, TitleMetadata tmd_,
                       std::size_t total_size_, const Common::ProgressCallback& callback_) {
 
     type = type_;
+    destination = destination_;
     header = {};
     meta = {};
+    {
+        std::lock_guard lock{streams_mutex};
+        streams_aborted = false;
+    }
 
     if (!FileUtil::CreateFullPath(destination)) {
         LOG_ERROR(Core, "Could not create {}", destination);
         return false;
     }
-    file = std::make_shared<HashedFile>(destination, "wb");
+    file = std::make_shared<HashedFile>(destination, "wb", CIAShareFlags);
     if (!*file) {
         LOG_ERROR(Core, "Could not open file {}", destination);
         return false;
@@ -104,14 +177,14 @@ bool CIABuilder::Init(CIABuildType type_, const std::string& destination, TitleM
     // Cert
     cert_offset = Common::AlignUp(header.header_size, CIA_ALIGNMENT);
     header.cert_size = CIA_CERT_SIZE;
-    if (!WriteCert()) {
+    if (!WriteCert(*file)) {
         LOG_ERROR(Core, "Could not write cert to file {}", destination);
         return false;
     }
 
     // Ticket
     ticket_offset = Common::AlignUp(cert_offset + header.cert_size, CIA_ALIGNMENT);
-    if (!WriteTicket()) {
+    if (!WriteTicket(*file)) {
         return false;
     }
 
@@ -122,6 +195,14 @@ bool CIABuilder::Init(CIABuildType type_, const std::string& destination, TitleM
     content_offset = Common::AlignUp(tmd_offset + header.tmd_size, CIA_ALIGNMENT);
     header.content_size = 0;
 
+    // Reserve space for the whole CIA. The contents have the same size as in the TMD.
+    std::size_t cia_size = content_offset + sizeof(meta);
+    for (const auto& chunk : tmd.tmd_chunks) {
+        cia_size += Common::AlignUp(static_cast<std::size_t>(chunk.size), CIA_ALIGNMENT);
+    }
+    file->Seek(0, SEEK_SET);
+    file->Preallocate(cia_size);
+
     // Meta will be written in Finalize
     header.meta_size = 0;
 
@@ -141,14 +222,14 @@ void CIABuilder::Cleanup() {
     file.reset();
 }
 
-bool CIABuilder::WriteCert() {
+bool CIABuilder::WriteCert(FileUtil::IOFile& out) {
     if (!Certs::IsLoaded()) {
         return false;
     }
 
-    file->Seek(cert_offset, SEEK_SET);
+    out.Seek(cert_offset, SEEK_SET);
     for (const auto& cert : CIACertNames) {
-        if (!Certs::Get(cert).Save(*file)) {
+        if (!Certs::Get(cert).Save(out)) {
             LOG_ERROR(Core, "Failed to write cert {}", cert);
             return false;
         }
@@ -157,8 +238,10 @@ bool CIABuilder::WriteCert() {
 }
 
 bool CIABuilder::FindLegitTicket(Ticket& ticket, u64 title_id) const {
-    if (ticket_db && ticket_db->tickets.count(title_id)) {
-        ticket = ticket_db->tickets.at(title_id);
+    if (ticket_db && ticket_db->HasTicket(title_id)) {
+        if (!ticket_db->GetTicket(title_id, ticket)) {
+            return false;
+        }
         if (!ticket.ValidateSignature()) {
             LOG_ERROR(Core, "Ticket in ticket.db for {:016x} is not legit", title_id);
             return false;
@@ -175,8 +258,8 @@ Ticket CIABuilder::BuildStandardTicket(u64 title_id) const {
 
     // Fill in common_key_index and title_key from either ticket.db (installed tickets)
     // or GM9 support files (encTitleKeys.bin) found on the SD card
-    if (ticket_db && ticket_db->tickets.count(title_id)) { // ticket.db
-        const auto& legit_ticket = ticket_db->tickets.at(title_id);
+    Ticket legit_ticket;
+    if (ticket_db && ticket_db->GetTicket(title_id, legit_ticket)) { // ticket.db
         ticket.body.common_key_index = legit_ticket.body.common_key_index;
         ticket.body.title_key = legit_ticket.body.title_key;
     } else if (enc_title_keys_bin && enc_title_keys_bin->count(title_id)) { // support files
@@ -189,26 +272,7 @@ Ticket CIABuilder::BuildStandardTicket(u64 title_id) const {
     return ticket;
 }
 
-static Key::AESKey GetTitleKey(const Ticket& ticket) {
-    Key::SelectCommonKeyIndex(ticket.body.common_key_index);
-    if (!Key::IsNormalKeyAvailable(Key::TicketCommonKey)) {
-        LOG_ERROR(Core, "Ticket common key is not available");
-        return {};
-    }
-
-    const auto ticket_key = Key::GetNormalKey(Key::TicketCommonKey);
-    Key::AESKey ctr{};
-    std::memcpy(ctr.data(), &ticket.body.title_id, 8);
-
-    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption aes;
-    aes.SetKeyWithIV(ticket_key.data(), ticket_key.size(), ctr.data());
-
-    Key::AESKey title_key = ticket.body.title_key;
-    aes.ProcessData(title_key.data(), title_key.data(), title_key.size());
-    return title_key;
-}
-
-bool CIABuilder::WriteTicket() {
+bool CIABuilder::WriteTicket(FileUtil::IOFile& out) {
     const auto title_id = tmd.GetTitleID();
 
     Ticket ticket;
@@ -219,12 +283,12 @@ bool CIABuilder::WriteTicket() {
     } else {
         ticket = BuildStandardTicket(title_id);
     }
-    title_key = GetTitleKey(ticket);
+    ticket.GetTitleKey(title_key);
 
     header.tik_size = static_cast<u32_le>(ticket.GetSize());
 
-    file->Seek(ticket_offset, SEEK_SET);
-    if (!ticket.Save(*file)) {
+    out.Seek(ticket_offset, SEEK_SET);
+    if (!ticket.Save(out)) {
         LOG_ERROR(Core, "Could not write ticket");
         return false;
     }
@@ -233,7 +297,9 @@ bool CIABuilder::WriteTicket() {
 
 class CIAEncryptAndHash final : public CryptoFunc {
 public:
-    explicit CIAEncryptAndHash(const Key::AESKey& key, const Key::AESKey& iv) {
+    explicit CIAEncryptAndHash(const Key::AESKey& key, const Key::AESKey& iv,
+                               bool encrypt_ = true)
+        : encrypt(encrypt_) {
         aes.SetKeyWithIV(key.data(), key.size(), iv.data());
     }
 
@@ -241,7 +307,9 @@ public:
 
     void ProcessData(u8* data, std::size_t size) override {
         sha.Update(data, size);
-        aes.ProcessData(data, data, size);
+        if (encrypt) {
+            aes.ProcessData(data, data, size);
+        }
     }
 
     bool VerifyHash(const u8* hash) {
@@ -251,9 +319,11 @@ public:
 private:
     CryptoPP::CBC_Mode<CryptoPP::AES>::Encryption aes;
     CryptoPP::SHA256 sha;
+    bool encrypt; ///< When false, only hashes the data
 };
 
-bool CIABuilder::AddContent(u16 content_id, NCCHContainer& ncch) {
+bool CIABuilder::AddContent(u16 content_id, NCCHContainer& ncch,
+                            std::shared_ptr<FileUtil::IOFile> decrypted_copy) {
     if (!ncch.Load()) {
         return false;
     }
@@ -271,7 +341,12 @@ bool CIABuilder::AddContent(u16 content_id, NCCHContainer& ncch) {
             std::lock_guard lock{abort_ncch_mutex};
             abort_ncch = &ncch;
         }
-        const auto ret = ncch.DecryptToFile(file, wrapper.Wrap(callback));
+        std::shared_ptr<FileUtil::IOFile> dest_file = file;
+        if (decrypted_copy) {
+            dest_file = std::make_shared<TeeFile>(
+                std::vector<std::shared_ptr<FileUtil::IOFile>>{file, std::move(decrypted_copy)});
+        }
+        const auto ret = ncch.DecryptToFile(std::move(dest_file), wrapper.Wrap(callback));
         {
             std::lock_guard lock{abort_ncch_mutex};
             abort_ncch = nullptr;
@@ -326,9 +401,150 @@ bool CIABuilder::AddContent(u16 content_id, NCCHContainer& ncch) {
     header.content_size = written - content_offset;
     header.SetContentPresent(tmd_chunk.index);
 
+    LoadMeta(tmd_chunk, ncch);
+    return true;
+}
+
+bool CIABuilder::AddContents(
+    const std::vector<u32>& content_ids,
+    const std::function<std::shared_ptr<FileUtil::IOFile>(u32)>& open_content) {
+
+    if (type == CIABuildType::Standard) {
+        LOG_ERROR(Core, "Contents of Standard CIAs must be added with AddContent");
+        return false;
+    }
+
+    // Lay out the contents ahead. Their sizes are known from the TMD, as they are not modified.
+    std::vector<std::size_t> offsets;
+    const std::size_t start = written;
+    for (const u32 content_id : content_ids) {
+        const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+        offsets.push_back(written);
+        written = Common::AlignUp(written + static_cast<std::size_t>(tmd_chunk.size),
+                                  CIA_ALIGNMENT);
+        header.SetContentPresent(tmd_chunk.index);
+    }
+    header.content_size = written - content_offset;
+
+    // Each content is written through a file of its own
+    if (!file->Flush()) {
+        LOG_ERROR(Core, "Could not flush {}", destination);
+        return false;
+    }
+
+    std::mutex progress_mutex;
+    std::vector<u64> progress(content_ids.size());
+    u64 total_progress = 0;
+
+    std::vector<std::size_t> free_streams;
+    for (std::size_t i = 0; i < stream_decryptors.size(); ++i) {
+        free_streams.push_back(i);
+    }
+
+    std::atomic_bool is_good{true};
+    Common::ParallelFor(
+        content_ids.size(),
+        [&](std::size_t i) {
+            if (!is_good) {
+                return;
+            }
+
+            const u32 content_id = content_ids[i];
+            const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+            auto source = open_content(content_id);
+            if (!source || !*source || source->GetSize() != tmd_chunk.size) {
+                LOG_ERROR(Core, "Could not open content {:08x} or its size is wrong",
+                          content_id);
+                is_good = false;
+                return;
+            }
+            auto dest = std::make_shared<FileUtil::IOFile>(destination, "r+b", CIAShareFlags);
+            if (!*dest || !dest->Seek(offsets[i], SEEK_SET)) {
+                LOG_ERROR(Core, "Could not open {} for content {:08x}", destination, content_id);
+                is_good = false;
+                return;
+            }
+
+            // Calculate IV
+            Key::AESKey iv{};
+            std::memcpy(iv.data(), &tmd_chunk.index, sizeof(tmd_chunk.index));
+
+            const bool is_encrypted = static_cast<u16>(tmd_chunk.type) & 0x01;
+            const auto crypto = std::make_shared<CIAEncryptAndHash>(title_key, iv, is_encrypted);
+
+            std::size_t stream;
+            {
+                std::lock_guard lock{streams_mutex};
+                if (streams_aborted) {
+                    is_good = false;
+                    return;
+                }
+                stream = free_streams.back();
+                free_streams.pop_back();
+            }
+
+            auto& stream_decryptor = stream_decryptors[stream];
+            stream_decryptor.SetCrypto(crypto);
+            const bool ret = stream_decryptor.CryptAndWriteFile(
+                std::move(source), static_cast<std::size_t>(tmd_chunk.size), std::move(dest),
+                [&, i, stream](u64 current, u64) {
+                    // Abort() may have been called after the stream was taken, but before the
+                    // decryptor started running, in which case it did not reach the decryptor
+                    {
+                        std::lock_guard lock{streams_mutex};
+                        if (streams_aborted) {
+                            stream_decryptors[stream].Abort();
+                            return;
+                        }
+                    }
+
+                    std::lock_guard lock{progress_mutex};
+                    total_progress += current - progress[i];
+                    progress[i] = current;
+                    callback(start + total_progress, total_size);
+                });
+
+            {
+                std::lock_guard lock{streams_mutex};
+                free_streams.push_back(stream);
+            }
+
+            if (!ret) {
+                is_good = false;
+                return;
+            }
+            if (!crypto->VerifyHash(tmd_chunk.hash.data())) {
+                LOG_ERROR(Core, "Hash dismatch for content {}", content_id);
+                is_good = false;
+            }
+        },
+        std::min(MaxStreams, Common::ResourceGovernor::Get().GetMaxThreads()));
+
+    if (!is_good) {
+        return false;
+    }
+
+    for (const u32 content_id : content_ids) {
+        const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+        if (tmd_chunk.index != TMDContentIndex::Main) {
+            continue;
+        }
+        NCCHContainer ncch(open_content(content_id));
+        if (!ncch.Load()) {
+            return false;
+        }
+        LoadMeta(tmd_chunk, ncch);
+    }
+
+    file->Seek(written, SEEK_SET);
+    wrapper.SetCurrent(written);
+    return true;
+}
+
+void CIABuilder::LoadMeta(const TitleMetadata::ContentChunk& tmd_chunk, NCCHContainer& ncch) {
     // DLCs do not have a meta
     if (tmd_chunk.index != TMDContentIndex::Main || (tmd.GetTitleID() >> 32) == 0x0004008c) {
-        return true;
+        return;
     }
 
     // Load meta if the content is main
@@ -340,15 +556,14 @@ bool CIABuilder::AddContent(u16 content_id, NCCHContainer& ncch) {
     // Note: GodMode9 has this hardcoded to 2.
     meta.core_version = ncch.exheader_header.arm11_system_local_caps.core_version;
 
-    std::vector<u8> smdh_buffer;
+    Common::PooledBuffer smdh_buffer;
     if (!ncch.LoadSectionExeFS("icon", smdh_buffer)) {
         LOG_WARNING(Core, "Failed to load icon in ExeFS");
-        return true;
+        return;
     }
     std::memcpy(meta.icon_data.data(), smdh_buffer.data(),
                 std::min(meta.icon_data.size(), smdh_buffer.size()));
     header.meta_size = sizeof(meta);
-    return true;
 }
 
 bool CIABuilder::Finalize() {
@@ -377,6 +592,143 @@ bool CIABuilder::Finalize() {
         }
     }
 
+    // Release the space preallocated beyond the end, e.g. for missing optional contents
+    if (file->Flush()) {
+        file->Resize(file->GetSize());
+    }
+
+    callback(total_size, total_size);
+    return true;
+}
+
+bool CIABuilder::BuildSequential(
+    CIABuildType type_, std::shared_ptr<FileUtil::IOFile> destination_file, TitleMetadata tmd_,
+    const std::vector<u32>& content_ids,
+    const std::function<std::shared_ptr<FileUtil::IOFile>(u32)>& open_content,
+    std::size_t total_size_, const Common::ProgressCallback& callback_) {
+
+    if (type_ == CIABuildType::Standard) {
+        LOG_ERROR(Core, "Standard CIAs cannot be built sequentially");
+        return false;
+    }
+
+    type = type_;
+    header = {};
+    meta = {};
+
+    tmd = std::move(tmd_);
+    if (!tmd.VerifyHashes() || !tmd.ValidateSignature()) {
+        LOG_ERROR(Core, "TMD is not legit");
+        return false;
+    }
+
+    // The sections before the contents are small, so they are assembled in memory first.
+    // The header is filled in last, when the whole layout is known.
+    MemoryFile head;
+    header.header_size = sizeof(header);
+
+    cert_offset = Common::AlignUp(header.header_size, CIA_ALIGNMENT);
+    header.cert_size = CIA_CERT_SIZE;
+    if (!WriteCert(head)) {
+        LOG_ERROR(Core, "Could not write cert");
+        return false;
+    }
+
+    ticket_offset = Common::AlignUp(cert_offset + header.cert_size, CIA_ALIGNMENT);
+    if (!WriteTicket(head)) {
+        return false;
+    }
+
+    // The TMD is used as is, with its hashes already known
+    tmd_offset = Common::AlignUp(ticket_offset + header.tik_size, CIA_ALIGNMENT);
+    header.tmd_size = static_cast<u32_le>(tmd.GetSize());
+    head.Seek(tmd_offset, SEEK_SET);
+    if (!tmd.Save(head)) {
+        return false;
+    }
+
+    content_offset = Common::AlignUp(tmd_offset + header.tmd_size, CIA_ALIGNMENT);
+    std::size_t content_end = content_offset;
+    for (const u32 content_id : content_ids) {
+        const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+        content_end = Common::AlignUp(content_end + static_cast<std::size_t>(tmd_chunk.size),
+                                      CIA_ALIGNMENT);
+        header.SetContentPresent(tmd_chunk.index);
+    }
+    header.content_size = content_end - content_offset;
+
+    // The meta comes from the main content, which is only read for this
+    for (const u32 content_id : content_ids) {
+        const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+        if (tmd_chunk.index != TMDContentIndex::Main) {
+            continue;
+        }
+        NCCHContainer ncch(open_content(content_id));
+        if (!ncch.Load()) {
+            return false;
+        }
+        LoadMeta(tmd_chunk, ncch);
+    }
+
+    head.Seek(0, SEEK_SET);
+    head.WriteBytes(&header, sizeof(header));
+    head.Seek(content_offset, SEEK_SET);
+
+    total_size = total_size_;
+    callback = callback_;
+    wrapper.total_size = total_size;
+
+    const auto& head_data = head.GetBuffer();
+    if (destination_file->WriteBytes(head_data.data(), head_data.size()) != head_data.size()) {
+        LOG_ERROR(Core, "Could not write CIA header");
+        return false;
+    }
+    written = head_data.size();
+    callback(written, total_size);
+
+    // Contents are padded with zeros instead of seeking, so that the output can be a stream
+    static constexpr std::array<u8, CIA_ALIGNMENT> Padding{};
+    for (const u32 content_id : content_ids) {
+        const auto& tmd_chunk = tmd.GetContentChunkByID(content_id);
+        const auto size = static_cast<std::size_t>(tmd_chunk.size);
+
+        auto source = open_content(content_id);
+        if (!source || !*source || source->GetSize() != size) {
+            LOG_ERROR(Core, "Could not open content {:08x} or its size is wrong", content_id);
+            return false;
+        }
+
+        // Calculate IV
+        Key::AESKey iv{};
+        std::memcpy(iv.data(), &tmd_chunk.index, sizeof(tmd_chunk.index));
+
+        const bool is_encrypted = static_cast<u16>(tmd_chunk.type) & 0x01;
+        const auto crypto = std::make_shared<CIAEncryptAndHash>(title_key, iv, is_encrypted);
+        decryptor.SetCrypto(crypto);
+        wrapper.SetCurrent(written);
+        if (!decryptor.CryptAndWriteFile(std::move(source), size, destination_file,
+                                         wrapper.Wrap(callback))) {
+            return false;
+        }
+        if (!crypto->VerifyHash(tmd_chunk.hash.data())) {
+            LOG_ERROR(Core, "Hash dismatch for content {}", content_id);
+            return false;
+        }
+
+        const std::size_t padding = Common::AlignUp(written + size, CIA_ALIGNMENT) - written - size;
+        if (destination_file->WriteBytes(Padding.data(), padding) != padding) {
+            LOG_ERROR(Core, "Could not write padding");
+            return false;
+        }
+        written += size + padding;
+    }
+
+    if (header.meta_size &&
+        destination_file->WriteBytes(&meta, sizeof(meta)) != sizeof(meta)) {
+        LOG_ERROR(Core, "Failed to write meta");
+        return false;
+    }
+
     callback(total_size, total_size);
     return true;
 }
@@ -387,8 +739,14 @@ void CIABuilder::Abort() {
         if (abort_ncch) {
             abort_ncch->AbortDecryptToFile();
         }
-    } else { // Abort the decryptor
+    } else { // Abort the decryptors
         decryptor.Abort();
+
+        std::lock_guard lock{streams_mutex};
+        streams_aborted = true;
+        for (auto& stream_decryptor : stream_decryptors) {
+            stream_decryptor.Abort();
+        }
     }
 }
 
@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <array>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 #include "common/file_util.h"
 #include "common/progress_callback.h"
 #include "common/swap.h"
@@ -18,12 +21,6 @@
 
 namespace Core {
 
-constexpr std::size_t CIA_CONTENT_MAX_COUNT = 0x10000;
-constexpr std::size_t CIA_CONTENT_BITS_SIZE = (CIA_CONTENT_MAX_COUNT / 8);
-constexpr std::size_t CIA_HEADER_SIZE = 0x2020;
-constexpr std::size_t CIA_CERT_SIZE = 0xA00;
-constexpr std::size_t CIA_METADATA_SIZE = 0x3AC0;
-
 struct Config;
 class EncTitleKeysBin;
 class HashedFile;
@@ -46,9 +43,23 @@ public:
 
     /**
      * Adds an NCCH content to the CIA.
+     * @param decrypted_copy Optional. For Standard CIAs, the decrypted NCCH is also written to
+     *                       this file, e.g. to dump a CXI in the same pass.
+     * @return true on success, false otherwise
+     */
+    bool AddContent(u16 content_id, NCCHContainer& ncch,
+                    std::shared_ptr<FileUtil::IOFile> decrypted_copy = nullptr);
+
+    /**
+     * Adds several contents to a Legit or PirateLegit CIA. As each content is encrypted
+     * independently (with its own IV), several of them are encrypted in parallel, each written
+     * at its offset in the CIA, computed ahead from the content sizes in the TMD.
+     * @param content_ids IDs of the contents to add, in TMD order
+     * @param open_content Opens a content by ID. May be called from any thread.
      * @return true on success, false otherwise
      */
-    bool AddContent(u16 content_id, NCCHContainer& ncch);
+    bool AddContents(const std::vector<u32>& content_ids,
+                     const std::function<std::shared_ptr<FileUtil::IOFile>(u32)>& open_content);
 
     /**
      * Finalizes this CIA and write remaining data.
@@ -57,51 +68,36 @@ public:
     bool Finalize();
 
     /**
-     * Aborts the current work. In fact, only usable during AddContent.
+     * Builds a whole Legit or PirateLegit CIA, writing it strictly sequentially without seeking,
+     * so that the destination can be a pipe or any other stream. The layout is computed ahead
+     * from the TMD, whose content hashes are known and used as is.
+     * Init, AddContent(s) and Finalize are not used with this.
+     * @param content_ids IDs of the contents to add, in TMD order
+     * @param open_content Opens a content by ID.
+     * @return true on success, false otherwise
+     */
+    bool BuildSequential(CIABuildType type, std::shared_ptr<FileUtil::IOFile> destination,
+                         TitleMetadata tmd, const std::vector<u32>& content_ids,
+                         const std::function<std::shared_ptr<FileUtil::IOFile>(u32)>& open_content,
+                         std::size_t total_size, const Common::ProgressCallback& callback);
+
+    /**
+     * Aborts the current work. In fact, only usable during AddContent(s) and BuildSequential.
      */
     void Abort();
 
 private:
-    struct Header {
-        u32_le header_size;
-        u16_le type;
-        u16_le version;
-        u32_le cert_size;
-        u32_le tik_size;
-        u32_le tmd_size;
-        u32_le meta_size;
-        u64_le content_size;
-        std::array<u8, CIA_CONTENT_BITS_SIZE> content_present;
-
-        bool IsContentPresent(u16 index) const {
-            // The content_present is a bit array which defines which content in the TMD
-            // is included in the CIA, so check the bit for this index and add if set.
-            // The bits in the content index are arranged w/ index 0 as the MSB, 7 as the LSB, etc.
-            return (content_present[index >> 3] & (0x80 >> (index & 7)));
-        }
-
-        void SetContentPresent(u16 index) {
-            content_present[index >> 3] |= (0x80 >> (index & 7));
-        }
-    };
-
-    static_assert(sizeof(Header) == CIA_HEADER_SIZE, "CIA Header structure size is wrong");
-
-    struct Metadata {
-        std::array<u64_le, 0x30> dependencies;
-        std::array<u8, 0x180> reserved;
-        u32_le core_version;
-        std::array<u8, 0xfc> reserved_2;
-        std::array<u8, 0x36c0> icon_data;
-    };
-
-    static_assert(sizeof(Metadata) == CIA_METADATA_SIZE, "CIA Metadata structure size is wrong");
-
-    bool WriteCert();
+    bool WriteCert(FileUtil::IOFile& out);
 
     bool FindLegitTicket(Ticket& ticket, u64 title_id) const;
     Ticket BuildStandardTicket(u64 title_id) const;
-    bool WriteTicket();
+    bool WriteTicket(FileUtil::IOFile& out);
+
+    /// Fills in the meta from the NCCH, if the content is the main content of an application.
+    void LoadMeta(const TitleMetadata::ContentChunk& tmd_chunk, NCCHContainer& ncch);
+
+    /// Maximum number of contents to encrypt in parallel in AddContents.
+    static constexpr std::size_t MaxStreams = 4;
 
     // Persistent state
     const std::shared_ptr<TicketDB> ticket_db;
@@ -110,8 +106,8 @@ private:
     // State of a single task
     CIABuildType type;
 
-    Header header{};
-    Metadata meta{};
+    CIAHeader header{};
+    CIAMetadata meta{};
 
     TitleMetadata tmd;
     Key::AESKey title_key{};
@@ -121,6 +117,7 @@ private:
     std::size_t tmd_offset{};
     std::size_t content_offset{};
 
+    std::string destination;
     std::shared_ptr<HashedFile> file;
     std::size_t written{}; // size written (with alignment)
     std::size_t total_size{};
@@ -132,6 +129,11 @@ private:
     NCCHContainer* abort_ncch{};
 
     FileDecryptor decryptor;
+
+    // Used by AddContents
+    std::array<FileDecryptor, MaxStreams> stream_decryptors;
+    std::mutex streams_mutex;
+    bool streams_aborted{};
 };
 
 } // namespace Core
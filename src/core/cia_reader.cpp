@@ -0,0 +1,262 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/buffer_pool.h"
+#include "common/common_funcs.h"
+#include "common/logging/log.h"
+#include "common/string_util.h"
+#include "common/thread.h"
+#include "core/cia_reader.h"
+#include "core/file_sys/block_hash.h"
+
+namespace Core {
+
+CIAReader::CIAReader(std::shared_ptr<FileUtil::IOFile> file_) : file(std::move(file_)) {}
+
+CIAReader::~CIAReader() = default;
+
+bool CIAReader::Load() {
+    if (is_loaded) {
+        return true;
+    }
+
+    TRY(file && file->IsOpen(), LOG_ERROR(Core, "File is not open"));
+    const u64 file_size = file->GetSize();
+
+    file->Seek(0, SEEK_SET);
+    TRY(file->ReadBytes(&header, sizeof(header)) == sizeof(header),
+        LOG_ERROR(Core, "Could not read header"));
+
+    TRY(header.header_size == CIA_HEADER_SIZE && header.type == 0 && header.version == 0,
+        LOG_ERROR(Core, "Invalid header (size {:#x}, type {}, version {})",
+                  static_cast<u32>(header.header_size), static_cast<u16>(header.type),
+                  static_cast<u16>(header.version)));
+    TRY(header.meta_size == 0 || header.meta_size == CIA_METADATA_SIZE,
+        LOG_ERROR(Core, "Invalid meta size {:#x}", static_cast<u32>(header.meta_size)));
+
+    // Sections are placed one after another, aligned to 0x40
+    cert_offset = Common::AlignUp<std::size_t>(header.header_size, CIA_ALIGNMENT);
+    ticket_offset = Common::AlignUp<std::size_t>(cert_offset + header.cert_size, CIA_ALIGNMENT);
+    tmd_offset = Common::AlignUp<std::size_t>(ticket_offset + header.tik_size, CIA_ALIGNMENT);
+    content_offset = Common::AlignUp<std::size_t>(tmd_offset + header.tmd_size, CIA_ALIGNMENT);
+    meta_offset = Common::AlignUp<std::size_t>(content_offset + header.content_size, CIA_ALIGNMENT);
+    TRY(meta_offset + header.meta_size <= file_size,
+        LOG_ERROR(Core, "File is too small ({:#x} bytes, expected {:#x})", file_size,
+                  meta_offset + header.meta_size));
+
+    // Cert chain, ticket and TMD are all small, so read them at once
+    std::vector<u8> data(content_offset);
+    file->Seek(0, SEEK_SET);
+    TRY(file->ReadBytes(data.data(), data.size()) == data.size(),
+        LOG_ERROR(Core, "Could not read CIA sections"));
+
+    TRY(LoadCerts(data));
+
+    TRY(ticket.Load(data, ticket_offset), LOG_ERROR(Core, "Could not load ticket"));
+    TRY(ticket.GetSize() <= header.tik_size, LOG_ERROR(Core, "Ticket exceeds its section"));
+
+    TRY(tmd.Load(data, tmd_offset), LOG_ERROR(Core, "Could not load TMD"));
+    TRY(tmd.GetSize() <= header.tmd_size, LOG_ERROR(Core, "TMD exceeds its section"));
+    TRY(tmd.VerifyHashes(), LOG_ERROR(Core, "TMD content info hashes mismatch"));
+
+    TRY(ticket.body.title_id == tmd.GetTitleID(),
+        LOG_ERROR(Core, "Title ID mismatch between ticket ({:016x}) and TMD ({:016x})",
+                  static_cast<u64>(ticket.body.title_id), tmd.GetTitleID()));
+
+    // Standard CIAs have fake tickets and modified TMDs, so this is only informational
+    if (Certs::IsLoaded()) {
+        if (!ticket.ValidateSignature()) {
+            LOG_INFO(Core, "Ticket is not legit");
+        }
+        if (!tmd.ValidateSignature()) {
+            LOG_INFO(Core, "TMD is not legit");
+        }
+    }
+
+    // Contents are stored in the order of the TMD chunks
+    u64 content_size = 0;
+    bool has_encrypted_content = false;
+    for (const auto& chunk : tmd.tmd_chunks) {
+        if (!header.IsContentPresent(chunk.index)) {
+            continue;
+        }
+        content_size += Common::AlignUp<u64>(chunk.size, CIA_ALIGNMENT);
+        if (static_cast<u16>(chunk.type) & TMDContentTypeFlag::Encrypted) {
+            has_encrypted_content = true;
+        }
+    }
+    TRY(content_size == header.content_size,
+        LOG_ERROR(Core, "Content size mismatch between header ({:#x}) and TMD ({:#x})",
+                  static_cast<u64>(header.content_size), content_size));
+
+    has_title_key = ticket.GetTitleKey(title_key);
+    TRY(has_title_key || !has_encrypted_content,
+        LOG_ERROR(Core, "Title key is required for encrypted contents but not available"));
+
+    is_loaded = true;
+    return true;
+}
+
+bool CIAReader::LoadCerts(const std::vector<u8>& data) {
+    certs.clear();
+
+    std::size_t offset = cert_offset;
+    for (const auto& name : CIACertNames) {
+        Certificate cert;
+        TRY(cert.Load(data, offset), LOG_ERROR(Core, "Could not load cert {}", name));
+        offset += cert.GetSize();
+
+        const auto issuer = Common::StringFromFixedZeroTerminatedBuffer(cert.body.issuer.data(),
+                                                                        cert.body.issuer.size());
+        const auto cert_name = Common::StringFromFixedZeroTerminatedBuffer(
+            cert.body.name.data(), cert.body.name.size());
+        TRY(issuer + "-" + cert_name == name,
+            LOG_ERROR(Core, "Cert {}-{} found where {} is expected", issuer, cert_name, name));
+
+        // The chain is fixed, so it must be identical to the one in certs.db when available
+        if (Certs::IsLoaded()) {
+            const auto& expected = Certs::Get(name);
+            TRY(cert.signature.data == expected.signature.data &&
+                    cert.public_key == expected.public_key,
+                LOG_ERROR(Core, "Cert {} does not match certs.db", name));
+        }
+        certs.emplace_back(std::move(cert));
+    }
+    TRY(offset - cert_offset == header.cert_size,
+        LOG_ERROR(Core, "Cert chain size mismatch ({:#x}, header says {:#x})",
+                  offset - cert_offset, static_cast<u32>(header.cert_size)));
+    return true;
+}
+
+/**
+ * Decrypts AES-CBC data in place on multiple threads. Each plaintext block depends only on its
+ * ciphertext block and the previous one, so the data is split into tasks with the ciphertext
+ * blocks preceding them as IVs. `iv` is then updated to continue with the data that follows.
+ */
+static void ParallelCBCDecrypt(const Key::AESKey& key, Key::AESKey& iv, u8* data,
+                               std::size_t size) {
+    static constexpr std::size_t TaskSize = 1024 * 1024;
+
+    ASSERT(size % Key::AES_BLOCK_SIZE == 0);
+    if (size == 0) {
+        return;
+    }
+
+    const std::size_t task_count = (size + TaskSize - 1) / TaskSize;
+    std::vector<Key::AESKey> ivs(task_count);
+    ivs[0] = iv;
+    for (std::size_t i = 1; i < task_count; ++i) {
+        std::memcpy(ivs[i].data(), data + i * TaskSize - Key::AES_BLOCK_SIZE,
+                    Key::AES_BLOCK_SIZE);
+    }
+    std::memcpy(iv.data(), data + size - Key::AES_BLOCK_SIZE, Key::AES_BLOCK_SIZE);
+
+    Common::ParallelFor(task_count, [&key, &ivs, data, size](std::size_t i) {
+        const std::size_t offset = i * TaskSize;
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption aes;
+        aes.SetKeyWithIV(key.data(), key.size(), ivs[i].data());
+        aes.ProcessData(data + offset, data + offset, std::min(TaskSize, size - offset));
+    });
+}
+
+bool CIAReader::VerifyContent(const TitleMetadata::ContentChunk& chunk, u64 offset,
+                              const Common::ProgressCallback& callback) {
+
+    const u64 size = chunk.size;
+    const bool is_encrypted = static_cast<u16>(chunk.type) & TMDContentTypeFlag::Encrypted;
+    TRY(!is_encrypted || size % Key::AES_BLOCK_SIZE == 0,
+        LOG_ERROR(Core, "Size of encrypted content {:08x} is not aligned",
+                  static_cast<u32>(chunk.id)));
+
+    // The IV is the content index, padded with zeros
+    Key::AESKey iv{};
+    std::memcpy(iv.data(), &chunk.index, sizeof(chunk.index));
+
+    // Contents are decrypted and hashed in chunks while the next one is being read.
+    static constexpr std::size_t ChunkSize = 16 * 1024 * 1024;
+    CryptoPP::SHA256 sha;
+    const auto ReadChunk = [this, &chunk, offset](Common::PooledBuffer& data, u64 pos,
+                                                 std::size_t length) {
+        data.resize(length);
+        TRY(file->Seek(offset + pos, SEEK_SET) && file->ReadBytes(data.data(), length) == length,
+            LOG_ERROR(Core, "Could not read content {:08x} at {:#x}",
+                      static_cast<u32>(chunk.id), pos));
+        return true;
+    };
+    const auto ProcessChunk = [this, &sha, &iv, is_encrypted, &callback](
+                                  Common::PooledBuffer& data, u64 /*pos*/) {
+        if (aborted) {
+            return false;
+        }
+        if (is_encrypted) {
+            ParallelCBCDecrypt(title_key, iv, data.data(), data.size());
+        }
+        sha.Update(data.data(), data.size());
+
+        verified_size += data.size();
+        callback(verified_size, total_size);
+        return true;
+    };
+    if (!ProcessInChunks(size, ChunkSize, ReadChunk, ProcessChunk)) {
+        return false;
+    }
+
+    TRY(sha.Verify(chunk.hash.data()),
+        LOG_ERROR(Core, "Hash mismatch for content {:08x}", static_cast<u32>(chunk.id)));
+    return true;
+}
+
+bool CIAReader::Verify(const Common::ProgressCallback& callback) {
+    if (!Load()) {
+        return false;
+    }
+
+    verified_size = 0;
+    total_size = header.content_size;
+    callback(0, total_size);
+
+    bool intact = true;
+    u64 offset = content_offset;
+    for (const auto& chunk : tmd.tmd_chunks) {
+        if (!header.IsContentPresent(chunk.index)) {
+            continue;
+        }
+        if (!VerifyContent(chunk, offset, callback)) {
+            if (aborted.exchange(false)) {
+                return false;
+            }
+            intact = false;
+        }
+        offset += Common::AlignUp<u64>(chunk.size, CIA_ALIGNMENT);
+        verified_size = offset - content_offset;
+    }
+
+    callback(total_size, total_size);
+    return intact;
+}
+
+void CIAReader::Abort() {
+    aborted = true;
+}
+
+const CIAHeader& CIAReader::GetHeader() const {
+    return header;
+}
+
+const Ticket& CIAReader::GetTicket() const {
+    return ticket;
+}
+
+const TitleMetadata& CIAReader::GetTMD() const {
+    return tmd;
+}
+
+} // namespace Core
@@ -0,0 +1,78 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+#include "common/progress_callback.h"
+#include "core/file_sys/certificate.h"
+#include "core/file_sys/cia_common.h"
+#include "core/file_sys/ticket.h"
+#include "core/file_sys/title_metadata.h"
+
+namespace Core {
+
+/**
+ * Reads back a CIA file (e.g. one built by CIABuilder) and validates it.
+ * Content decryption is done on multiple threads, as CBC decryption (unlike encryption) does
+ * not depend on the result of previous blocks.
+ */
+class CIAReader {
+public:
+    explicit CIAReader(std::shared_ptr<FileUtil::IOFile> file);
+    ~CIAReader();
+
+    /**
+     * Loads and validates the header layout, the cert chain, the ticket and the TMD.
+     * Signatures are only checked for consistency with the certs when the certs are loaded,
+     * and invalid signatures are allowed (as Standard CIAs have fake tickets), though logged.
+     * @return true on success, false otherwise
+     */
+    bool Load();
+
+    /**
+     * Loads the CIA and verifies the hash of every content present against the TMD.
+     * @return true if the CIA is intact, false otherwise
+     */
+    bool Verify(const Common::ProgressCallback& callback = [](u64, u64) {});
+
+    /// Aborts Verify.
+    void Abort();
+
+    const CIAHeader& GetHeader() const;
+    const Ticket& GetTicket() const;
+    const TitleMetadata& GetTMD() const;
+
+private:
+    bool LoadCerts(const std::vector<u8>& data);
+    bool VerifyContent(const TitleMetadata::ContentChunk& chunk, u64 offset,
+                       const Common::ProgressCallback& callback);
+
+    std::shared_ptr<FileUtil::IOFile> file;
+    bool is_loaded = false;
+
+    CIAHeader header{};
+    std::vector<Certificate> certs;
+    Ticket ticket;
+    TitleMetadata tmd;
+    Key::AESKey title_key{};
+    bool has_title_key = false;
+
+    std::size_t cert_offset{};
+    std::size_t ticket_offset{};
+    std::size_t tmd_offset{};
+    std::size_t content_offset{};
+    std::size_t meta_offset{};
+
+    u64 verified_size{};
+    u64 total_size{};
+
+    std::atomic_bool aborted{};
+};
+
+} // namespace Core
@@ -0,0 +1,261 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <fmt/format.h>
+#include "common/string_util.h"
+#include "common/thread.h"
+#include "core/content_filter.h"
+
+namespace Core {
+
+bool ContentFilter::IsEmpty() const {
+    return name.empty() && id_prefix.empty() && types.empty() && !already_exists &&
+           min_size == 0 && max_size == std::numeric_limits<u64>::max();
+}
+
+constexpr std::array<std::pair<std::string_view, ContentType>, ContentTypeCount>
+    ContentTypeNames{{
+        {"title", ContentType::Title},
+        {"savegame", ContentType::Savegame},
+        {"nandsavegame", ContentType::NandSavegame},
+        {"extdata", ContentType::Extdata},
+        {"nandextdata", ContentType::NandExtdata},
+        {"sysdata", ContentType::Sysdata},
+        {"nandtitle", ContentType::NandTitle},
+    }};
+
+static bool ParseTypes(std::string_view value, std::vector<ContentType>& out) {
+    std::vector<std::string> names;
+    Common::SplitString(std::string{value}, ',', names);
+    for (const auto& name : names) {
+        const auto iter = std::find_if(ContentTypeNames.begin(), ContentTypeNames.end(),
+                                       [&name](const auto& pair) { return pair.first == name; });
+        if (iter == ContentTypeNames.end()) {
+            return false;
+        }
+        out.emplace_back(iter->second);
+    }
+    return !out.empty();
+}
+
+/// Parses sizes like 1024, 100K, 1.5G
+static bool ParseSize(std::string_view value, u64& out) {
+    u64 multiplier = 1;
+    if (!value.empty()) {
+        switch (value.back()) {
+        case 'k':
+            multiplier = 1024;
+            break;
+        case 'm':
+            multiplier = 1024 * 1024;
+            break;
+        case 'g':
+            multiplier = 1024 * 1024 * 1024;
+            break;
+        }
+        if (multiplier != 1) {
+            value.remove_suffix(1);
+        }
+    }
+    if (value.empty()) {
+        return false;
+    }
+
+    const std::string str{value};
+    char* end;
+    const double number = std::strtod(str.c_str(), &end);
+    if (end != str.c_str() + str.size() || !std::isfinite(number) || number < 0) {
+        return false;
+    }
+    // The conversion is undefined for values that do not fit, i.e. 2^64 and above
+    const double size = number * static_cast<double>(multiplier);
+    if (size >= 18446744073709551616.0) {
+        return false;
+    }
+    out = static_cast<u64>(size);
+    return true;
+}
+
+static bool ParseSizeRange(std::string_view value, u64& min, u64& max) {
+    if (value.empty()) {
+        return false;
+    }
+    // Bounds given with > and < are exclusive, while ranges are inclusive
+    u64 lower;
+    u64 upper;
+    if (value.front() == '>') {
+        if (!ParseSize(value.substr(1), lower) || lower == std::numeric_limits<u64>::max()) {
+            return false;
+        }
+        min = lower + 1;
+        return true;
+    }
+    if (value.front() == '<') {
+        if (!ParseSize(value.substr(1), upper) || upper == 0) {
+            return false;
+        }
+        max = upper - 1;
+        return true;
+    }
+    if (const auto pos = value.find('-'); pos != std::string_view::npos) {
+        if (!ParseSize(value.substr(0, pos), lower) || !ParseSize(value.substr(pos + 1), upper)) {
+            return false;
+        }
+        min = lower;
+        max = upper;
+        return true;
+    }
+    // Exact size
+    if (!ParseSize(value, lower)) {
+        return false;
+    }
+    min = max = lower;
+    return true;
+}
+
+static bool ParseCriterion(std::string_view key, std::string_view value, ContentFilter& out) {
+    if (key == "id") {
+        if (value.substr(0, 2) == "0x") {
+            value.remove_prefix(2);
+        }
+        const bool is_hex = !value.empty() && value.size() <= 16 &&
+                            std::all_of(value.begin(), value.end(), [](char c) {
+                                return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+                            });
+        if (!is_hex) {
+            return false;
+        }
+        out.id_prefix = value;
+        return true;
+    }
+    if (key == "type") {
+        return ParseTypes(value, out.types);
+    }
+    if (key == "exists") {
+        if (value == "yes" || value == "true") {
+            out.already_exists = true;
+        } else if (value == "no" || value == "false") {
+            out.already_exists = false;
+        } else {
+            return false;
+        }
+        return true;
+    }
+    if (key == "size") {
+        return ParseSizeRange(value, out.min_size, out.max_size);
+    }
+    return false;
+}
+
+ContentFilter ContentFilter::Parse(std::string_view query) {
+    ContentFilter filter;
+
+    std::vector<std::string> words;
+    Common::SplitString(Common::ToLower(std::string{query}), ' ', words);
+    for (const auto& word : words) {
+        if (word.empty()) {
+            continue;
+        }
+
+        const auto pos = word.find(':');
+        if (pos != std::string::npos) {
+            const std::string_view word_view{word};
+            if (ParseCriterion(word_view.substr(0, pos), word_view.substr(pos + 1), filter)) {
+                continue;
+            }
+        }
+
+        if (!filter.name.empty()) {
+            filter.name.push_back(' ');
+        }
+        filter.name.append(word);
+    }
+    return filter;
+}
+
+ContentFilterIndex::ContentFilterIndex(const std::vector<ContentSpecifier>& contents) {
+    // Application names, for Savegames and Extdata
+    std::unordered_map<u64, const std::string*> title_names;   // title ID -> name
+    std::unordered_map<u64, const std::string*> extdata_names; // extdata ID -> name
+    for (const auto& content : contents) {
+        if (content.type == ContentType::Title && (content.id >> 32) == 0x00040000) {
+            title_names.emplace(content.id, &content.name);
+            extdata_names.emplace(content.extdata_id, &content.name);
+        }
+    }
+
+    entries.reserve(contents.size());
+    for (const auto& content : contents) {
+        const std::string* name = &content.name;
+        if (content.type == ContentType::Savegame && title_names.count(content.id)) {
+            name = title_names.at(content.id);
+        } else if (content.type == ContentType::Extdata && extdata_names.count(content.id)) {
+            name = extdata_names.at(content.id);
+        }
+        entries.push_back({Common::ToLower(*name), fmt::format("{:016x}", content.id),
+                           content.type, content.already_exists, content.maximum_size});
+    }
+}
+
+ContentFilterIndex::~ContentFilterIndex() = default;
+
+bool ContentFilterIndex::Matches(const Entry& entry, const ContentFilter& filter,
+                                 const std::string& lower_name) const {
+    if (!filter.types.empty() &&
+        std::find(filter.types.begin(), filter.types.end(), entry.type) == filter.types.end()) {
+        return false;
+    }
+    if (filter.already_exists && *filter.already_exists != entry.already_exists) {
+        return false;
+    }
+    if (entry.size < filter.min_size || entry.size > filter.max_size) {
+        return false;
+    }
+    if (entry.id.compare(0, filter.id_prefix.size(), filter.id_prefix) != 0) {
+        return false;
+    }
+    // Contents without names are displayed with their IDs, so also search there
+    if (!lower_name.empty() && entry.name.find(lower_name) == std::string::npos &&
+        entry.id.find(lower_name) == std::string::npos) {
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::size_t> ContentFilterIndex::Evaluate(const ContentFilter& filter) const {
+    const std::string lower_name = Common::ToLower(filter.name);
+
+    // Entries are evaluated in chunks, as each one is too cheap to be worth a task of its own.
+    constexpr std::size_t ChunkSize = 256;
+    const std::size_t chunk_count = (entries.size() + ChunkSize - 1) / ChunkSize;
+
+    std::vector<u8> matches(entries.size());
+    Common::ParallelFor(chunk_count, [this, &filter, &lower_name, &matches](std::size_t chunk) {
+        const std::size_t end = std::min(entries.size(), (chunk + 1) * ChunkSize);
+        for (std::size_t i = chunk * ChunkSize; i < end; ++i) {
+            matches[i] = Matches(entries[i], filter, lower_name);
+        }
+    });
+
+    std::vector<std::size_t> out;
+    for (std::size_t i = 0; i < matches.size(); ++i) {
+        if (matches[i]) {
+            out.emplace_back(i);
+        }
+    }
+    return out;
+}
+
+std::size_t ContentFilterIndex::Size() const {
+    return entries.size();
+}
+
+} // namespace Core
@@ -0,0 +1,78 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/common_types.h"
+#include "core/importer.h"
+
+namespace Core {
+
+/**
+ * Criteria for selecting contents. A content matches when it satisfies all of them.
+ */
+struct ContentFilter {
+    std::string name;               ///< Case-insensitive substring of the name. Empty for any.
+    std::string id_prefix;          ///< Prefix of the 16-digit hex ID. Empty for any.
+    std::vector<ContentType> types; ///< Allowed content types. Empty for any.
+    std::optional<bool> already_exists;
+    u64 min_size = 0;
+    u64 max_size = std::numeric_limits<u64>::max();
+
+    bool IsEmpty() const;
+
+    /**
+     * Parses a filter from a query string. Words of the form key:value set the corresponding
+     * criteria, and all other words make up the name. Supported keys:
+     *   id:0004000000055d00   ID prefix, with or without 0x
+     *   type:title,savegame   Content types (title, savegame, extdata, sysdata, nandtitle,
+     *                         nandsavegame, nandextdata)
+     *   exists:yes / exists:no
+     *   size:>100M, size:<1G, size:100M-1G   Size range, with optional K/M/G suffix.
+     *                                        > and < are exclusive, ranges are inclusive.
+     * Malformed criteria are treated as part of the name.
+     */
+    static ContentFilter Parse(std::string_view query);
+};
+
+/**
+ * Search index over a list of contents. Names (and IDs) are preprocessed once, so that
+ * evaluating filters only involves plain comparisons.
+ * Savegames and Extdata, which do not have names themselves, are matched with the names of
+ * their applications.
+ */
+class ContentFilterIndex {
+public:
+    explicit ContentFilterIndex(const std::vector<ContentSpecifier>& contents);
+    ~ContentFilterIndex();
+
+    /**
+     * Evaluates a filter over the contents. Large lists are evaluated in parallel.
+     * @return Positions of the matching contents in the list, in ascending order
+     */
+    std::vector<std::size_t> Evaluate(const ContentFilter& filter) const;
+
+    std::size_t Size() const;
+
+private:
+    struct Entry {
+        std::string name; ///< Lowercase
+        std::string id;   ///< Lowercase hex, 16 digits
+        ContentType type;
+        bool already_exists;
+        u64 size;
+    };
+
+    bool Matches(const Entry& entry, const ContentFilter& filter,
+                 const std::string& lower_name) const;
+
+    std::vector<Entry> entries;
+};
+
+} // namespace Core
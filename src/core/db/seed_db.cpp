@@ -2,6 +2,8 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
+#include <vector>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "common/swap.h"
@@ -19,31 +21,28 @@ bool SeedDB::AddFromFile(const std::string& path) {
         LOG_ERROR(Service_FS, "Failed to open seed database");
         return false;
     }
-    u32_le count;
-    if (file.ReadBytes(&count, sizeof(count)) != sizeof(count)) {
+
+    // Read the whole file at once and parse it from memory
+    const auto data = file.GetData();
+    SeedDBHeader header;
+    if (data.size() < sizeof(header)) {
         LOG_ERROR(Service_FS, "Failed to read seed database count fully");
         return false;
     }
-    if (!file.Seek(SEEDDB_PADDING_BYTES, SEEK_CUR)) {
-        LOG_ERROR(Service_FS, "Failed to skip seed database padding");
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    const u32 count = header.count;
+    if (data.size() < sizeof(header) + static_cast<std::size_t>(count) * SEEDDB_ENTRY_SIZE) {
+        LOG_ERROR(Service_FS, "Seed database is too small for {} seeds", count);
         return false;
     }
-    for (u32 i = 0; i < count; ++i) {
-        u64_le title_id;
-        if (!file.ReadBytes(&title_id, sizeof(title_id))) {
-            LOG_ERROR(Service_FS, "Failed to read seed {} title ID", i);
-            return false;
-        }
-        Seed seed;
-        if (!file.ReadBytes(seed.data(), seed.size())) {
-            LOG_ERROR(Service_FS, "Failed to read seed {} data", i);
-            return false;
-        }
-        if (!file.Seek(SEEDDB_ENTRY_PADDING_BYTES, SEEK_CUR)) {
-            LOG_ERROR(Service_FS, "Failed to skip past seed {} padding", i);
-            return false;
-        }
-        seeds.emplace(title_id, std::move(seed));
+
+    seeds.reserve(seeds.size() + count);
+    const u8* ptr = data.data() + sizeof(header);
+    for (u32 i = 0; i < count; ++i, ptr += SEEDDB_ENTRY_SIZE) {
+        SeedDBEntry entry;
+        std::memcpy(&entry, ptr, sizeof(entry));
+        seeds.emplace(entry.title_id, entry.seed);
     }
     return true;
 }
@@ -58,38 +57,31 @@ bool SeedDB::Save(const std::string& path) const {
         LOG_ERROR(Service_FS, "Failed to open seed database");
         return false;
     }
-    u32_le count{static_cast<u32>(seeds.size())};
-    if (file.WriteBytes(&count, sizeof(count)) != sizeof(count)) {
-        LOG_ERROR(Service_FS, "Failed to write seed database count fully");
-        return false;
-    }
-    std::array<u8, SEEDDB_PADDING_BYTES> padding{};
-    if (file.WriteBytes(padding.data(), padding.size()) != padding.size()) {
-        LOG_ERROR(Service_FS, "Failed to write seed database padding fully");
-        return false;
-    }
+
+    // Build the whole file in memory so that it can be written at once
+    std::vector<u8> data(GetSize());
+    SeedDBHeader header{};
+    header.count = static_cast<u32>(seeds.size());
+    std::memcpy(data.data(), &header, sizeof(header));
+
+    u8* ptr = data.data() + sizeof(header);
     for (const auto& [title_id, seed] : seeds) {
-        const u64_le raw_title_id{title_id}; // for endianess
-        if (file.WriteBytes(&raw_title_id, sizeof(raw_title_id)) != sizeof(raw_title_id)) {
-            LOG_ERROR(Service_FS, "Failed to write seed {:016x} title ID fully", title_id);
-            return false;
-        }
+        SeedDBEntry entry{};
+        entry.title_id = title_id;
+        entry.seed = seed;
+        std::memcpy(ptr, &entry, sizeof(entry));
+        ptr += SEEDDB_ENTRY_SIZE;
+    }
 
-        if (file.WriteBytes(seed.data(), seed.size()) != seed.size()) {
-            LOG_ERROR(Service_FS, "Failed to write seed {:016x} data fully", title_id);
-            return false;
-        }
-        static constexpr std::array<u8, SEEDDB_ENTRY_PADDING_BYTES> Padding{};
-        if (file.WriteBytes(Padding.data(), Padding.size()) != Padding.size()) {
-            LOG_ERROR(Service_FS, "Failed to write seed {:016x} padding fully", title_id);
-            return false;
-        }
+    if (file.WriteBytes(data.data(), data.size()) != data.size()) {
+        LOG_ERROR(Service_FS, "Failed to write seed database fully");
+        return false;
     }
     return true;
 }
 
 std::size_t SeedDB::GetSize() const {
-    return sizeof(u32) + SEEDDB_PADDING_BYTES + seeds.size() * SEEDDB_ENTRY_SIZE;
+    return sizeof(SeedDBHeader) + seeds.size() * SEEDDB_ENTRY_SIZE;
 }
 
 } // namespace Core
@@ -5,8 +5,11 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <unordered_map>
+#include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/swap.h"
 
 namespace Core {
 
@@ -15,6 +18,20 @@ constexpr std::size_t SEEDDB_ENTRY_PADDING_BYTES{8};
 constexpr std::size_t SEEDDB_ENTRY_SIZE{32};
 
 using Seed = std::array<u8, 16>;
+
+struct SeedDBHeader {
+    u32_le count;
+    INSERT_PADDING_BYTES(SEEDDB_PADDING_BYTES);
+};
+static_assert(sizeof(SeedDBHeader) == 16, "SeedDBHeader has incorrect size");
+
+struct SeedDBEntry {
+    u64_le title_id;
+    Seed seed;
+    INSERT_PADDING_BYTES(SEEDDB_ENTRY_PADDING_BYTES);
+};
+static_assert(sizeof(SeedDBEntry) == SEEDDB_ENTRY_SIZE, "SeedDBEntry has incorrect size");
+
 class SeedDB {
 public:
     bool AddFromFile(const std::string& path);
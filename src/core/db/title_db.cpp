@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include "common/file_util.h"
 #include "common/logging/log.h"
 #include "core/db/title_db.h"
@@ -15,7 +16,7 @@ bool TitleDB::AddFromData(std::vector<u8> data) {
 
 bool TitleDB::AddFromFile(const std::string& path) {
     FileUtil::IOFile file(path, "rb");
-    DataContainer container(file.GetData());
+    DataContainer container(file.GetData<Common::PooledBuffer>());
     std::vector<std::vector<u8>> data;
     if (container.IsGood() && container.GetIVFCLevel4Data(data)) {
         return Init(std::move(data[0]));
@@ -31,6 +32,13 @@ bool TitleDB::Init(std::vector<u8> data) {
         return false;
     }
 
+    std::size_t count = 0;
+    for (u32 cur = directory_entry_table[1].first_file_index; cur != 0;
+         cur = file_entry_table[cur].next_sibling_index) {
+        count++;
+    }
+    titles.reserve(titles.size() + count);
+
     u32 cur = directory_entry_table[1].first_file_index;
     while (cur != 0) {
         if (!LoadTitleInfo(cur)) {
@@ -75,8 +83,18 @@ bool TitleDB::LoadTitleInfo(u32 index) {
 }
 
 bool TicketDB::AddFromFile(const std::string& path) {
+    if (ticket_index.Size() != 0) {
+        // The FAT of this DB is still needed for loading tickets, so keep the new DB separate
+        auto db = std::make_unique<TicketDB>();
+        if (!db->AddFromFile(path)) {
+            return false;
+        }
+        linked_dbs.emplace_back(std::move(db));
+        return true;
+    }
+
     FileUtil::IOFile file(path, "rb");
-    DataContainer container(file.GetData());
+    DataContainer container(file.GetData<Common::PooledBuffer>());
     std::vector<std::vector<u8>> data;
     if (container.IsGood() && container.GetIVFCLevel4Data(data)) {
         return Init(std::move(data[0]));
@@ -92,32 +110,38 @@ bool TicketDB::Init(std::vector<u8> data) {
         return false;
     }
 
+    // Only index the tickets here. They are parsed on demand in GetTicket.
     u32 cur = directory_entry_table[1].first_file_index;
     while (cur != 0) {
-        if (!LoadTicket(cur)) {
-            return false;
-        }
+        ticket_index.Insert(file_entry_table[cur].title_id, cur);
         cur = file_entry_table[cur].next_sibling_index;
     }
     return true;
 }
 
-bool TicketDB::CheckMagic() const {
-    if (header.pre_header.db_magic != MakeMagic('T', 'I', 'C', 'K')) {
-        LOG_ERROR(Core, "File is invalid, decryption errors may have happened.");
+bool TicketDB::HasTicket(u64 title_id) const {
+    return ticket_index.Contains(title_id) ||
+           std::any_of(linked_dbs.begin(), linked_dbs.end(),
+                       [title_id](const auto& db) { return db->HasTicket(title_id); });
+}
+
+bool TicketDB::GetTicket(u64 title_id, Ticket& out) const {
+    const u32 index = ticket_index.Find(title_id);
+    if (index == Common::FlatIndex::InvalidValue) {
+        for (const auto& db : linked_dbs) {
+            if (db->HasTicket(title_id)) {
+                return db->GetTicket(title_id, out);
+            }
+        }
         return false;
     }
 
-    if (header.fat_header.magic != MakeMagic('B', 'D', 'R', 'I') ||
-        header.fat_header.version != 0x30000) {
-
-        LOG_ERROR(Core, "File is invalid, decryption errors may have happened.");
-        return false;
+    std::lock_guard lock{loaded_tickets_mutex};
+    if (const auto iter = loaded_tickets.find(index); iter != loaded_tickets.end()) {
+        out = iter->second;
+        return true;
     }
-    return true;
-}
 
-bool TicketDB::LoadTicket(u32 index) {
     std::vector<u8> data;
     if (!GetFileData(data, index)) {
         return false;
@@ -125,9 +149,25 @@ bool TicketDB::LoadTicket(u32 index) {
 
     Ticket ticket;
     if (!ticket.Load(std::move(data), 8)) { // there is a 8-byte header
+        LOG_ERROR(Core, "Ticket for {:016x} is invalid", title_id);
+        return false;
+    }
+    out = loaded_tickets.emplace(index, std::move(ticket)).first->second;
+    return true;
+}
+
+bool TicketDB::CheckMagic() const {
+    if (header.pre_header.db_magic != MakeMagic('T', 'I', 'C', 'K')) {
+        LOG_ERROR(Core, "File is invalid, decryption errors may have happened.");
+        return false;
+    }
+
+    if (header.fat_header.magic != MakeMagic('B', 'D', 'R', 'I') ||
+        header.fat_header.version != 0x30000) {
+
+        LOG_ERROR(Core, "File is invalid, decryption errors may have happened.");
         return false;
     }
-    tickets.emplace(file_entry_table[index].title_id, ticket);
     return true;
 }
 
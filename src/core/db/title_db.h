@@ -5,10 +5,13 @@
 #pragma once
 
 #include <array>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/flat_index.h"
 #include "common/swap.h"
 #include "core/file_sys/data/inner_fat.hpp"
 #include "core/file_sys/ticket.h"
@@ -73,7 +76,7 @@ public:
     bool AddFromFile(const std::string& path);
     ~TitleDB();
 
-    std::unordered_map<u64, TitleInfoEntry> titles;
+    Common::FlatMap<TitleInfoEntry> titles;
 
 private:
     bool Init(std::vector<u8> data);
@@ -97,12 +100,27 @@ public:
     bool AddFromFile(const std::string& path);
     ~TicketDB();
 
-    std::unordered_map<u64, Ticket> tickets;
+    /// Returns whether a ticket exists for a title.
+    bool HasTicket(u64 title_id) const;
+
+    /**
+     * Gets the ticket of a title. Tickets are parsed the first time they are looked up.
+     * @return true on success, false if the ticket does not exist or is invalid
+     */
+    bool GetTicket(u64 title_id, Ticket& out) const;
 
 private:
     bool Init(std::vector<u8> data);
     bool CheckMagic() const;
-    bool LoadTicket(u32 index);
+
+    Common::FlatIndex ticket_index; // Title ID -> file entry index
+
+    // Tickets that have already been parsed, by file entry index.
+    mutable std::unordered_map<u32, Ticket> loaded_tickets;
+    mutable std::mutex loaded_tickets_mutex;
+
+    // ticket.dbs of the other linked NANDs, only consulted when a title is not found in this one.
+    std::vector<std::unique_ptr<TicketDB>> linked_dbs;
 
     friend InnerFAT_TicketDB;
 };
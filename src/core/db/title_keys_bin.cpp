@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <cstring>
 #include "common/file_util.h"
 #include "core/db/title_keys_bin.h"
 
@@ -14,25 +15,33 @@ bool LoadTitleKeysBin(TitleKeysMap& out, const std::string& path) {
         return false;
     }
 
+    // Read the whole file at once and parse it from memory
+    const auto data = file.GetData();
     TitleKeysBinHeader header;
-    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+    if (data.size() < sizeof(header)) {
         LOG_ERROR(Core, "Could not read header from {}", path);
         return false;
     }
+    std::memcpy(&header, data.data(), sizeof(header));
 
-    for (std::size_t i = 0; i < header.num_entries; ++i) {
-        TitleKeysBinEntry entry;
-        if (file.ReadBytes(&entry, sizeof(entry)) != sizeof(entry)) {
-            LOG_ERROR(Core, "Could not read entry {} from {}", i, path);
-            return false;
-        }
-        out.emplace(entry.title_id, entry);
+    const std::size_t expected_size =
+        sizeof(header) + static_cast<std::size_t>(header.num_entries) * sizeof(TitleKeysBinEntry);
+    if (data.size() < expected_size) {
+        LOG_ERROR(Core, "File {} is too small for {} entries", path, header.num_entries);
+        return false;
     }
-
-    if (file.Tell() != file.GetSize()) {
+    if (data.size() > expected_size) {
         LOG_ERROR(Core, "File {} has redundant data, may be corrupted", path);
         return false;
     }
+
+    out.reserve(out.size() + header.num_entries);
+    const u8* ptr = data.data() + sizeof(header);
+    for (std::size_t i = 0; i < header.num_entries; ++i, ptr += sizeof(TitleKeysBinEntry)) {
+        TitleKeysBinEntry entry;
+        std::memcpy(&entry, ptr, sizeof(entry));
+        out.emplace(entry.title_id, entry);
+    }
     return true;
 }
 
@@ -5,9 +5,10 @@
 #pragma once
 
 #include <array>
-#include <unordered_map>
+#include <string>
 #include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/flat_index.h"
 #include "common/swap.h"
 
 namespace Core {
@@ -26,7 +27,7 @@ struct TitleKeysBinEntry {
 };
 static_assert(sizeof(TitleKeysBinEntry) == 32);
 
-using TitleKeysMap = std::unordered_map<u64, TitleKeysBinEntry>;
+using TitleKeysMap = Common::FlatMap<TitleKeysBinEntry>;
 class EncTitleKeysBin : public TitleKeysMap {};
 
 // GM9 support files encTitleKeys.bin and decTitleKeys.bin.
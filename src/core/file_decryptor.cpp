@@ -10,6 +10,7 @@
 #include <cryptopp/sha.h>
 #include "common/assert.h"
 #include "common/file_util.h"
+#include "common/resource_governor.h"
 #include "common/string_util.h"
 #include "core/file_decryptor.h"
 
@@ -51,6 +52,12 @@ bool FileDecryptor::CryptAndWriteFile(std::shared_ptr<FileUtil::IOFile> source_,
     callback = callback_;
 
     total_size = size;
+    for (auto& buffer : buffers) {
+        buffer.resize(BufferSize);
+    }
+
+    // The size to write is known, so reserve the space ahead
+    destination->Preallocate(size);
 
     is_good = is_running = true;
 
@@ -69,9 +76,12 @@ bool FileDecryptor::CryptAndWriteFile(std::shared_ptr<FileUtil::IOFile> source_,
         decrypt_thread->join();
     }
 
-    // Release the files
+    // Release the files and the buffers
     source.reset();
     destination.reset();
+    for (auto& buffer : buffers) {
+        buffer = Common::PooledBuffer{};
+    }
 
     bool ret = is_good;
     is_good = true;
@@ -82,6 +92,9 @@ void FileDecryptor::DataReadLoop() {
     std::size_t current_buffer = 0;
     bool is_first_run = true;
 
+    auto& governor = Common::ResourceGovernor::Get();
+    governor.ApplyThreadPriority();
+
     if (!*source) {
         is_good = false;
         completion_event.Set();
@@ -89,6 +102,11 @@ void FileDecryptor::DataReadLoop() {
     }
 
     std::size_t file_size = total_size;
+    std::size_t read_size = 0;
+
+    // The source is only read once, so read it ahead, and drop what has been read from the cache
+    source->Advise(0, total_size, FileUtil::IOFile::CacheAdvice::Sequential);
+    source->Advise(0, 2 * CacheWindowSize, FileUtil::IOFile::CacheAdvice::WillNeed);
 
     while (is_running && file_size > 0) {
         if (is_first_run) {
@@ -100,12 +118,21 @@ void FileDecryptor::DataReadLoop() {
         }
 
         const auto bytes_to_read = std::min(BufferSize, file_size);
+        governor.Acquire(bytes_to_read);
         if (source->ReadBytes(buffers[current_buffer].data(), bytes_to_read) != bytes_to_read) {
             is_good = false;
             completion_event.Set();
             return;
         }
         file_size -= bytes_to_read;
+        read_size += bytes_to_read;
+
+        if (read_size % CacheWindowSize == 0) {
+            source->Advise(CacheWindowSize, CacheWindowSize,
+                           FileUtil::IOFile::CacheAdvice::WillNeed);
+            source->Advise(-static_cast<s64>(CacheWindowSize), CacheWindowSize,
+                           FileUtil::IOFile::CacheAdvice::DontNeed);
+        }
 
         data_read_event[current_buffer].Set();
         current_buffer = (current_buffer + 1) % buffers.size();
@@ -114,6 +141,7 @@ void FileDecryptor::DataReadLoop() {
 
 void FileDecryptor::DataDecryptLoop() {
     std::size_t current_buffer = 0;
+    Common::ResourceGovernor::Get().ApplyThreadPriority();
     std::size_t file_size = total_size;
 
     while (is_running && file_size > 0) {
@@ -132,6 +160,9 @@ void FileDecryptor::DataDecryptLoop() {
 void FileDecryptor::DataWriteLoop() {
     std::size_t current_buffer = 0;
 
+    auto& governor = Common::ResourceGovernor::Get();
+    governor.ApplyThreadPriority();
+
     if (!*destination) {
         is_good = false;
         completion_event.Set();
@@ -158,6 +189,7 @@ void FileDecryptor::DataWriteLoop() {
         }
 
         const auto bytes_to_write = std::min(BufferSize, file_size);
+        governor.Acquire(bytes_to_write);
         if (destination->WriteBytes(buffers[current_buffer].data(), bytes_to_write) !=
             bytes_to_write) {
             is_good = false;
@@ -167,6 +199,18 @@ void FileDecryptor::DataWriteLoop() {
         file_size -= bytes_to_write;
         imported_size += bytes_to_write;
 
+        // Start writing back each window as soon as it is complete, and drop the one before
+        // from the cache once it is on disk, so that the written data does not pile up there
+        if (imported_size % CacheWindowSize == 0) {
+            constexpr auto Window = static_cast<s64>(CacheWindowSize);
+            destination->Writeback(-Window, CacheWindowSize, false);
+            if (imported_size >= 2 * CacheWindowSize) {
+                destination->Writeback(-2 * Window, CacheWindowSize, true);
+                destination->Advise(-2 * Window, CacheWindowSize,
+                                    FileUtil::IOFile::CacheAdvice::DontNeed);
+            }
+        }
+
         data_written_event[current_buffer].Set();
         current_buffer = (current_buffer + 1) % buffers.size();
     }
@@ -8,6 +8,7 @@
 #include <atomic>
 #include <memory>
 #include <string>
+#include "common/buffer_pool.h"
 #include "common/common_types.h"
 #include "common/progress_callback.h"
 #include "common/thread.h"
@@ -58,6 +59,8 @@ public:
 
 private:
     static constexpr std::size_t BufferSize = 16 * 1024; // 16 KB
+    /// Granularity of page cache management (read-ahead, writeback and dropping)
+    static constexpr std::size_t CacheWindowSize = 8 * 1024 * 1024; // 8 MB
 
     std::shared_ptr<FileUtil::IOFile> source;
     std::shared_ptr<FileUtil::IOFile> destination;
@@ -65,7 +68,8 @@ private:
 
     std::size_t total_size{};
 
-    std::array<std::array<u8, BufferSize>, 3> buffers;
+    /// Taken from the buffer pool while running, so that they are shared by all decryptors
+    std::array<Common::PooledBuffer, 3> buffers;
     std::array<Common::Event, 3> data_read_event;
     std::array<Common::Event, 3> data_decrypted_event;
     std::array<Common::Event, 3> data_written_event;
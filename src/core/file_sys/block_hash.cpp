@@ -0,0 +1,102 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <future>
+#include <cryptopp/sha.h>
+#include "common/logging/log.h"
+#include "common/thread.h"
+#include "core/file_sys/block_hash.h"
+
+namespace Core {
+
+bool FindCorruptBlocks(std::vector<std::pair<u64, u64>>& out, const u8* data, u64 size,
+                       u32 block_size_log2, const u8* hashes, u64 hashes_size) {
+    if (block_size_log2 == 0 || block_size_log2 >= 32) {
+        LOG_ERROR(Core, "Invalid block size {}", block_size_log2);
+        return false;
+    }
+
+    const u64 block_size = u64{1} << block_size_log2;
+    const std::size_t block_count = static_cast<std::size_t>((size + block_size - 1) / block_size);
+    if (hashes_size < block_count * CryptoPP::SHA256::DIGESTSIZE) {
+        LOG_ERROR(Core, "Hash size {:#x} is too small for {} blocks", hashes_size, block_count);
+        return false;
+    }
+
+    // Blocks are usually small, so hash a number of them in each task.
+    constexpr std::size_t BlocksPerTask = 64;
+    std::vector<u8> good(block_count);
+    Common::ParallelFor(
+        (block_count + BlocksPerTask - 1) / BlocksPerTask,
+        [data, size, block_size, block_count, hashes, &good](std::size_t task) {
+            CryptoPP::SHA256 sha;
+            std::vector<u8> padding;
+
+            const std::size_t end = std::min(block_count, (task + 1) * BlocksPerTask);
+            for (std::size_t i = task * BlocksPerTask; i < end; ++i) {
+                const u64 offset = i * block_size;
+                const u64 length = std::min(block_size, size - offset);
+                sha.Update(data + offset, static_cast<std::size_t>(length));
+                if (length < block_size) {
+                    padding.resize(static_cast<std::size_t>(block_size - length));
+                    sha.Update(padding.data(), padding.size());
+                }
+                good[i] = sha.Verify(hashes + i * CryptoPP::SHA256::DIGESTSIZE);
+            }
+        });
+
+    const std::size_t first_range = out.size();
+    for (std::size_t i = 0; i < block_count; ++i) {
+        if (good[i]) {
+            continue;
+        }
+        const u64 offset = i * block_size;
+        if (out.size() > first_range && out.back().first + out.back().second == offset) {
+            out.back().second += block_size;
+        } else {
+            out.emplace_back(offset, block_size);
+        }
+    }
+    // The last range may end past the data
+    if (out.size() > first_range) {
+        out.back().second = std::min(out.back().second, size - out.back().first);
+    }
+    return true;
+}
+
+bool ProcessInChunks(
+    u64 size, std::size_t chunk_size,
+    const std::function<bool(Common::PooledBuffer&, u64 offset, std::size_t length)>& read,
+    const std::function<bool(Common::PooledBuffer&, u64 offset)>& process) {
+
+    const auto ReadChunk = [&read, size, chunk_size](u64 offset) {
+        Common::PooledBuffer chunk;
+        if (!read(chunk, offset,
+                  static_cast<std::size_t>(std::min<u64>(chunk_size, size - offset)))) {
+            chunk.clear();
+        }
+        return chunk;
+    };
+
+    std::future<Common::PooledBuffer> next_chunk;
+    if (size > 0) {
+        next_chunk = std::async(std::launch::async, ReadChunk, u64{0});
+    }
+    for (u64 offset = 0; offset < size; offset += chunk_size) {
+        auto chunk = next_chunk.get();
+        if (chunk.empty()) {
+            return false;
+        }
+        if (offset + chunk_size < size) {
+            next_chunk = std::async(std::launch::async, ReadChunk, offset + chunk_size);
+        }
+        if (!process(chunk, offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Core
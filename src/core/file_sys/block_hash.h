@@ -0,0 +1,37 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <functional>
+#include <utility>
+#include <vector>
+#include "common/buffer_pool.h"
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Checks consecutive blocks of data against a table of their SHA-256 hashes, as in IVFC hash
+ * trees. The blocks are hashed in parallel. The last block is hashed with zero padding.
+ * @param out Ranges (offset, size) of corrupt blocks, relative to data, are appended to it.
+ * @param block_size_log2 Block size, in log2
+ * @return false if the parameters are invalid, true otherwise (even if blocks are corrupt)
+ */
+bool FindCorruptBlocks(std::vector<std::pair<u64, u64>>& out, const u8* data, u64 size,
+                       u32 block_size_log2, const u8* hashes, u64 hashes_size);
+
+/**
+ * Reads data that may be several GBs in chunks and processes them in order. The next chunk is
+ * read on another thread while the current one is being processed.
+ * @param read Reads `length` bytes at `offset` (relative to the data) into the buffer.
+ * @param process Processes the chunk read at `offset`. Returning false stops the loop.
+ * @return false if reading or processing a chunk failed, true otherwise
+ */
+bool ProcessInChunks(
+    u64 size, std::size_t chunk_size,
+    const std::function<bool(Common::PooledBuffer&, u64 offset, std::size_t length)>& read,
+    const std::function<bool(Common::PooledBuffer&, u64 offset)>& process);
+
+} // namespace Core
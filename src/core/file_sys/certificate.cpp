@@ -98,7 +98,7 @@ bool Load(const std::string& path) {
     Clear();
 
     FileUtil::IOFile file(path, "rb");
-    DataContainer container(file.GetData());
+    DataContainer container(file.GetData<Common::PooledBuffer>());
     std::vector<std::vector<u8>> data;
     if (!container.IsGood() || !container.GetIVFCLevel4Data(data)) {
         return false;
@@ -152,6 +152,7 @@ bool IsLoaded() {
 void Clear() {
     g_is_loaded = false;
     g_certs.clear();
+    Signature::ClearVerificationCache();
 }
 
 const Certificate& Get(const std::string& name) {
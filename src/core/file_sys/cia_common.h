@@ -6,9 +6,17 @@
 
 #include <array>
 #include "common/common_types.h"
+#include "common/swap.h"
 
 namespace Core {
 
+constexpr std::size_t CIA_CONTENT_MAX_COUNT = 0x10000;
+constexpr std::size_t CIA_CONTENT_BITS_SIZE = (CIA_CONTENT_MAX_COUNT / 8);
+constexpr std::size_t CIA_HEADER_SIZE = 0x2020;
+constexpr std::size_t CIA_CERT_SIZE = 0xA00;
+constexpr std::size_t CIA_METADATA_SIZE = 0x3AC0;
+constexpr std::size_t CIA_ALIGNMENT = 0x40;
+
 /// Full names of the certificates contained in a CIA.
 constexpr std::array<const char*, 3> CIACertNames{{
     "Root-CA00000003",
@@ -22,4 +30,39 @@ enum class CIABuildType {
     Legit,       /// Fully legit, with personal ticket containing console ID and eshop account
 };
 
+struct CIAHeader {
+    u32_le header_size;
+    u16_le type;
+    u16_le version;
+    u32_le cert_size;
+    u32_le tik_size;
+    u32_le tmd_size;
+    u32_le meta_size;
+    u64_le content_size;
+    std::array<u8, CIA_CONTENT_BITS_SIZE> content_present;
+
+    bool IsContentPresent(u16 index) const {
+        // The content_present is a bit array which defines which content in the TMD
+        // is included in the CIA, so check the bit for this index and add if set.
+        // The bits in the content index are arranged w/ index 0 as the MSB, 7 as the LSB, etc.
+        return (content_present[index >> 3] & (0x80 >> (index & 7)));
+    }
+
+    void SetContentPresent(u16 index) {
+        content_present[index >> 3] |= (0x80 >> (index & 7));
+    }
+};
+
+static_assert(sizeof(CIAHeader) == CIA_HEADER_SIZE, "CIA Header structure size is wrong");
+
+struct CIAMetadata {
+    std::array<u64_le, 0x30> dependencies;
+    std::array<u8, 0x180> reserved;
+    u32_le core_version;
+    std::array<u8, 0xfc> reserved_2;
+    std::array<u8, 0x36c0> icon_data;
+};
+
+static_assert(sizeof(CIAMetadata) == CIA_METADATA_SIZE, "CIA Metadata structure size is wrong");
+
 } // namespace Core
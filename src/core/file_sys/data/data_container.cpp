@@ -3,14 +3,16 @@
 // Refer to the license.txt file included.
 
 #include <cmath>
+#include <cryptopp/sha.h>
 #include "common/assert.h"
 #include "common/common_funcs.h"
+#include "core/file_sys/block_hash.h"
 #include "core/file_sys/data/data_container.h"
 
 namespace Core {
 
 DPFSContainer::DPFSContainer(DPFSDescriptor descriptor_, u8 level1_selector_,
-                             std::vector<u32_le> data_)
+                             Common::PooledVector<u32_le> data_)
     : descriptor(std::move(descriptor_)), level1_selector(level1_selector_),
       data(std::move(data_)) {
 
@@ -49,8 +51,8 @@ bool DPFSContainer::GetByte(u8& out, u8 level, u8 selector, u64 index) const {
     return true;
 }
 
-bool DPFSContainer::GetLevel3Data(std::vector<u8>& out) const {
-    std::vector<u8> level3_data(descriptor.levels[2].size);
+bool DPFSContainer::GetLevel3Data(Common::PooledBuffer& out) const {
+    Common::PooledBuffer level3_data(descriptor.levels[2].size);
     for (std::size_t i = 0; i < level3_data.size(); i++) {
         const u64 level2_bit_index = static_cast<u64>(i) >> descriptor.levels[2].block_size;
         const u64 level1_bit_index = (level2_bit_index / 8) >> descriptor.levels[1].block_size;
@@ -66,7 +68,13 @@ bool DPFSContainer::GetLevel3Data(std::vector<u8>& out) const {
     return true;
 }
 
-DataContainer::DataContainer(std::vector<u8> data_) : data(std::move(data_)) {
+Common::MemoryBudget::Reservation DataContainer::ReserveMemory(u64 size) {
+    // Unwrapping holds up to 4 copies of the data at the same time
+    static constexpr u64 UnwrapFactor = 4;
+    return Common::MemoryBudget::Get().Reserve(size * UnwrapFactor);
+}
+
+DataContainer::DataContainer(Common::PooledBuffer data_) : data(std::move(data_)) {
     if (data.size() < 0x200) {
         LOG_ERROR(Core, "Data size {:X} is too small", data.size());
         is_good = false;
@@ -105,6 +113,8 @@ bool DataContainer::InitAsDISA() {
     } else {
         partition_table_offset = header.secondary_partition_table_offset;
     }
+    partition_table_size = header.partition_table_size;
+    partition_table_hash = header.sha_hash;
 
     partition_count = header.partition_count;
 
@@ -133,6 +143,8 @@ bool DataContainer::InitAsDIFF() {
     } else {
         partition_table_offset = header.secondary_partition_table_offset;
     }
+    partition_table_size = header.partition_table_size;
+    partition_table_hash = header.sha_hash;
 
     partition_count = 1;
     partition_descriptors = {{/* offset */ 0, /* size */ header.partition_table_size}};
@@ -141,10 +153,11 @@ bool DataContainer::InitAsDIFF() {
     return true;
 }
 
-bool DataContainer::GetPartitionData(std::vector<u8>& out, u8 index) const {
-    auto partition_descriptor_offset = partition_table_offset + partition_descriptors[index].offset;
+bool DataContainer::LoadPartitionDescriptors(u8 index, DIFIHeader& difi,
+                                             IVFCDescriptor& ivfc) const {
+    const auto partition_descriptor_offset =
+        partition_table_offset + partition_descriptors[index].offset;
 
-    DIFIHeader difi;
     TRY_MEMCPY(&difi, data, partition_descriptor_offset, sizeof(difi));
 
     if (difi.magic != MakeMagic('D', 'I', 'F', 'I') || difi.version != 0x10000) {
@@ -153,9 +166,34 @@ bool DataContainer::GetPartitionData(std::vector<u8>& out, u8 index) const {
     }
 
     ASSERT_MSG(difi.ivfc.size >= sizeof(IVFCDescriptor), "IVFC descriptor size is too small");
+    TRY_MEMCPY(&ivfc, data, partition_descriptor_offset + difi.ivfc.offset, sizeof(ivfc));
+    return true;
+}
+
+bool DataContainer::GetDPFSLevel3Data(Common::PooledBuffer& out, u8 index,
+                                      const DIFIHeader& difi) const {
+    const auto partition_descriptor_offset =
+        partition_table_offset + partition_descriptors[index].offset;
+
+    ASSERT_MSG(difi.dpfs.size >= sizeof(DPFSDescriptor), "DPFS descriptor size is too small");
+    DPFSDescriptor dpfs_descriptor;
+    TRY_MEMCPY(&dpfs_descriptor, data, partition_descriptor_offset + difi.dpfs.offset,
+               sizeof(dpfs_descriptor));
+
+    Common::PooledVector<u32_le> partition_data(partitions[index].size / 4);
+    TRY_MEMCPY(partition_data.data(), data, partitions[index].offset, partitions[index].size);
+
+    DPFSContainer dpfs_container(std::move(dpfs_descriptor), difi.dpfs_level1_selector,
+                                 std::move(partition_data));
+    return dpfs_container.GetLevel3Data(out);
+}
+
+bool DataContainer::GetPartitionData(std::vector<u8>& out, u8 index) const {
+    DIFIHeader difi;
     IVFCDescriptor ivfc_descriptor;
-    TRY_MEMCPY(&ivfc_descriptor, data, partition_descriptor_offset + difi.ivfc.offset,
-               sizeof(ivfc_descriptor));
+    if (!LoadPartitionDescriptors(index, difi, ivfc_descriptor)) {
+        return false;
+    }
 
     if (difi.enable_external_IVFC_level_4) {
         if (data.size() < partitions[index].offset + difi.external_IVFC_level_4_offset +
@@ -171,19 +209,8 @@ bool DataContainer::GetPartitionData(std::vector<u8>& out, u8 index) const {
     }
 
     // Unwrap DPFS Tree
-    ASSERT_MSG(difi.dpfs.size >= sizeof(DPFSDescriptor), "DPFS descriptor size is too small");
-    DPFSDescriptor dpfs_descriptor;
-    TRY_MEMCPY(&dpfs_descriptor, data, partition_descriptor_offset + difi.dpfs.offset,
-               sizeof(dpfs_descriptor));
-
-    std::vector<u32_le> partition_data(partitions[index].size / 4);
-    TRY_MEMCPY(partition_data.data(), data, partitions[index].offset, partitions[index].size);
-
-    DPFSContainer dpfs_container(std::move(dpfs_descriptor), difi.dpfs_level1_selector,
-                                 std::move(partition_data));
-
-    std::vector<u8> ivfc_data;
-    if (!dpfs_container.GetLevel3Data(ivfc_data)) {
+    Common::PooledBuffer ivfc_data;
+    if (!GetDPFSLevel3Data(ivfc_data, index, difi)) {
         return false;
     }
 
@@ -208,4 +235,76 @@ bool DataContainer::GetIVFCLevel4Data(std::vector<std::vector<u8>>& out) const {
     }
 }
 
+bool DataContainer::VerifyPartition(u8 index, std::vector<CorruptBlockRange>& corrupt) const {
+    DIFIHeader difi;
+    IVFCDescriptor ivfc_descriptor;
+    if (!LoadPartitionDescriptors(index, difi, ivfc_descriptor)) {
+        return false;
+    }
+
+    // Levels 1 to 3 (and also 4 when not external) are stored in the DPFS tree
+    Common::PooledBuffer ivfc_data;
+    if (!GetDPFSLevel3Data(ivfc_data, index, difi)) {
+        return false;
+    }
+
+    // Level 1 is verified by the master hash
+    const auto master_hash_offset =
+        partition_table_offset + partition_descriptors[index].offset + difi.partition_hash.offset;
+    TRY(data.size() >= master_hash_offset + difi.partition_hash.size,
+        LOG_ERROR(Core, "File size is too small"));
+    const u8* hashes = data.data() + master_hash_offset;
+    u64 hashes_size = difi.partition_hash.size;
+
+    for (u8 level = 0; level < ivfc_descriptor.levels.size(); ++level) {
+        const auto& descriptor = ivfc_descriptor.levels[level];
+
+        const u8* level_data;
+        if (level == 3 && difi.enable_external_IVFC_level_4) {
+            const auto offset = partitions[index].offset + difi.external_IVFC_level_4_offset;
+            TRY(data.size() >= offset + descriptor.size, LOG_ERROR(Core, "File size is too small"));
+            level_data = data.data() + offset;
+        } else {
+            TRY(ivfc_data.size() >= descriptor.offset + descriptor.size,
+                LOG_ERROR(Core, "IVFC data size is too small"));
+            level_data = ivfc_data.data() + descriptor.offset;
+        }
+
+        std::vector<std::pair<u64, u64>> ranges;
+        if (!FindCorruptBlocks(ranges, level_data, descriptor.size, descriptor.block_size, hashes,
+                               hashes_size)) {
+            return false;
+        }
+        for (const auto& [offset, size] : ranges) {
+            LOG_WARNING(Core, "Partition {} IVFC level {}: corrupt data at {:#x}-{:#x}", index,
+                        level + 1, offset, offset + size);
+            corrupt.push_back({index, static_cast<u8>(level + 1), offset, size});
+        }
+
+        hashes = level_data;
+        hashes_size = descriptor.size;
+    }
+    return true;
+}
+
+bool DataContainer::Verify(std::vector<CorruptBlockRange>& corrupt) const {
+    corrupt.clear();
+
+    TRY(data.size() >= partition_table_offset + partition_table_size,
+        LOG_ERROR(Core, "File size is too small"));
+    if (!CryptoPP::SHA256().VerifyDigest(partition_table_hash.data(),
+                                         data.data() + partition_table_offset,
+                                         partition_table_size)) {
+        LOG_ERROR(Core, "Partition table hash mismatch");
+        return false;
+    }
+
+    for (u8 i = 0; i < partition_count; ++i) {
+        if (!VerifyPartition(i, corrupt)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace Core
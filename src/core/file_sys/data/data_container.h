@@ -5,9 +5,12 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <vector>
+#include "common/buffer_pool.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
+#include "common/memory_budget.h"
 #include "common/swap.h"
 
 namespace Core {
@@ -91,10 +94,11 @@ static_assert(sizeof(DPFSDescriptor) == 0x50, "Size of DPFS descriptor is incorr
 
 class DPFSContainer {
 public:
-    explicit DPFSContainer(DPFSDescriptor descriptor, u8 level1_selector, std::vector<u32_le> data);
+    explicit DPFSContainer(DPFSDescriptor descriptor, u8 level1_selector,
+                           Common::PooledVector<u32_le> data);
 
     /// Unwraps the DPFS Tree, returning actual data in Level3.
-    bool GetLevel3Data(std::vector<u8>& out) const;
+    bool GetLevel3Data(Common::PooledBuffer& out) const;
 
 private:
     bool GetBit(u8& out, u8 level, u8 selector, u64 index) const;
@@ -102,7 +106,21 @@ private:
 
     DPFSDescriptor descriptor;
     u8 level1_selector;
-    std::vector<u32_le> data;
+    Common::PooledVector<u32_le> data;
+};
+
+/// A range of consecutive IVFC blocks whose hashes do not match.
+struct CorruptBlockRange {
+    u8 partition;
+    u8 level;   ///< IVFC level, 1 to 4
+    u64 offset; ///< Offset of the first corrupt block in the level
+    u64 size;
+};
+
+/// The corrupt blocks found in a DISA/DIFF file of a savegame or extdata.
+struct CorruptFile {
+    std::string path;
+    std::vector<CorruptBlockRange> ranges;
 };
 
 /**
@@ -110,25 +128,54 @@ private:
  */
 class DataContainer {
 public:
-    explicit DataContainer(std::vector<u8> data);
+    explicit DataContainer(Common::PooledBuffer data);
     ~DataContainer();
 
+    /**
+     * Reserves the memory needed to load and unwrap a container of `size` bytes, i.e. the raw
+     * data, the DPFS partitions, the IVFC levels and the extracted level 4 data.
+     * Blocks while other operations are using up the memory budget.
+     */
+    static Common::MemoryBudget::Reservation ReserveMemory(u64 size);
+
     /// Unwraps the whole container, returning the data in IVFC Level 4 of all partitions.
     bool GetIVFCLevel4Data(std::vector<std::vector<u8>>& out) const;
 
+    /**
+     * Verifies the integrity of the container, i.e. the partition table hash and the IVFC hash
+     * trees (levels 1 to 4, starting from the master hash) of all partitions.
+     * The blocks of each level are hashed in parallel.
+     * Corrupt blocks do not fail the verification, as they may be free blocks that are never
+     * read. They are returned for the caller to report instead.
+     * @param corrupt Receives the ranges of blocks that failed verification.
+     * @return false if the container could not be verified, i.e. it is malformed or its
+     *         partition table is corrupted. true otherwise, even if blocks are corrupt.
+     */
+    bool Verify(std::vector<CorruptBlockRange>& corrupt) const;
+
     bool IsGood() const;
 
 private:
     bool InitAsDISA();
     bool InitAsDIFF();
 
+    /// Loads the DIFI header and the IVFC descriptor of a partition.
+    bool LoadPartitionDescriptors(u8 index, DIFIHeader& difi, IVFCDescriptor& ivfc) const;
+
+    /// Unwraps the DPFS tree of a partition, returning the IVFC levels stored in it.
+    bool GetDPFSLevel3Data(Common::PooledBuffer& out, u8 index, const DIFIHeader& difi) const;
+
     /// Unwraps the whole container, returning the data in IVFC Level 4 of a partition.
     bool GetPartitionData(std::vector<u8>& out, u8 index) const;
 
+    bool VerifyPartition(u8 index, std::vector<CorruptBlockRange>& corrupt) const;
+
     bool is_good = false;
-    std::vector<u8> data;
+    Common::PooledBuffer data;
     u32 partition_count;
     u64_le partition_table_offset;
+    u64_le partition_table_size;
+    std::array<u8, 0x20> partition_table_hash;
     std::vector<DataDescriptor> partition_descriptors;
     std::vector<DataDescriptor> partitions;
 };
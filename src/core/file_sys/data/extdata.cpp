@@ -8,8 +8,8 @@
 
 namespace Core {
 
-Extdata::Extdata(std::string data_path_, const SDMCDecryptor& decryptor_)
-    : data_path(std::move(data_path_)), decryptor(&decryptor_) {
+Extdata::Extdata(std::string data_path_, const SDMCDecryptor& decryptor_, bool verify_)
+    : data_path(std::move(data_path_)), decryptor(&decryptor_), verify(verify_) {
 
     if (data_path.back() != '/' && data_path.back() != '\\') {
         data_path += '/';
@@ -19,7 +19,8 @@ Extdata::Extdata(std::string data_path_, const SDMCDecryptor& decryptor_)
     is_good = Init();
 }
 
-Extdata::Extdata(std::string data_path_) : data_path(std::move(data_path_)) {
+Extdata::Extdata(std::string data_path_, bool verify_)
+    : data_path(std::move(data_path_)), verify(verify_) {
     if (data_path.back() != '/' && data_path.back() != '\\') {
         data_path += '/';
     }
@@ -44,6 +45,10 @@ bool Extdata::IsGood() const {
     return is_good;
 }
 
+const std::vector<CorruptFile>& Extdata::GetCorruptFiles() const {
+    return corrupt_files;
+}
+
 bool Extdata::Extract(std::string path) const {
     if (path.back() != '/' && path.back() != '\\') {
         path += '/';
@@ -58,25 +63,52 @@ bool Extdata::Extract(std::string path) const {
     return FileUtil::WriteBytesToFile(path + "metadata", &format_info, sizeof(format_info));
 }
 
-std::vector<u8> Extdata::ReadFile(const std::string& path) const {
+Common::PooledBuffer Extdata::ReadFile(const std::string& path) const {
     if (use_decryptor) {
-        return decryptor->DecryptFile(path);
+        return decryptor->DecryptFile<Common::PooledBuffer>(path);
     } else {
         FileUtil::IOFile file(path, "rb");
-        return file.GetData();
+        return file.GetData<Common::PooledBuffer>();
+    }
+}
+
+u64 Extdata::GetFileSize(const std::string& path) const {
+    if (use_decryptor) {
+        return decryptor->GetFileSize(path);
+    } else {
+        return FileUtil::Exists(path) ? FileUtil::GetSize(path) : 0;
+    }
+}
+
+bool Extdata::VerifyContainer(const DataContainer& container, const std::string& path) const {
+    if (!verify) {
+        return true;
+    }
+
+    std::vector<CorruptBlockRange> corrupt;
+    if (!container.Verify(corrupt)) {
+        LOG_ERROR(Core, "Failed to verify file {}", path);
+        return false;
     }
+    if (!corrupt.empty()) {
+        LOG_WARNING(Core, "File {} has corrupt blocks", path);
+        corrupt_files.push_back({path, std::move(corrupt)});
+    }
+    return true;
 }
 
 bool Extdata::Init() {
     // Read VSXE file
-    auto vsxe_raw = ReadFile(data_path + "00000000/00000001");
+    const auto vsxe_path = data_path + "00000000/00000001";
+    const auto reservation = DataContainer::ReserveMemory(GetFileSize(vsxe_path));
+    auto vsxe_raw = ReadFile(vsxe_path);
     if (vsxe_raw.empty()) {
         LOG_ERROR(Core, "Failed to load or decrypt VSXE");
         return false;
     }
 
     const DataContainer vsxe_container(std::move(vsxe_raw));
-    if (!vsxe_container.IsGood()) {
+    if (!vsxe_container.IsGood() || !VerifyContainer(vsxe_container, vsxe_path)) {
         return false;
     }
 
@@ -98,6 +130,7 @@ bool Extdata::ExtractFile(const std::string& path, u32 index) const {
     const std::string device_file_path =
         fmt::format("{}{:08x}/{:08x}", data_path, sub_directory_id, sub_file_id);
 
+    const auto reservation = DataContainer::ReserveMemory(GetFileSize(device_file_path));
     auto container_data = ReadFile(device_file_path);
     if (container_data.empty()) { // File does not exist?
         LOG_WARNING(Core, "Ignoring file {}", device_file_path);
@@ -105,7 +138,7 @@ bool Extdata::ExtractFile(const std::string& path, u32 index) const {
     }
 
     const DataContainer container(std::move(container_data));
-    if (!container.IsGood()) {
+    if (!container.IsGood() || !VerifyContainer(container, device_file_path)) {
         return false;
     }
 
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <vector>
+#include "core/file_sys/data/data_container.h"
 #include "core/file_sys/data/inner_fat.hpp"
 
 namespace Core {
@@ -16,24 +18,33 @@ public:
      * Loads an SD extdata folder.
      * @param data_path Path to the ENCRYPTED SD extdata folder, relative to decryptor root
      * @param decryptor Const reference to the SDMCDecryptor.
+     * @param verify Whether to verify the integrity of the files (IVFC hashes)
      */
-    explicit Extdata(std::string data_path, const SDMCDecryptor& decryptor);
+    explicit Extdata(std::string data_path, const SDMCDecryptor& decryptor, bool verify = false);
 
     /**
      * Loads an Extdata folder without encryption.
      * @param data_path Path to the DECRYPTED extdata folder
+     * @param verify Whether to verify the integrity of the files (IVFC hashes)
      */
-    explicit Extdata(std::string data_path);
+    explicit Extdata(std::string data_path, bool verify = false);
 
     ~Extdata();
 
     bool IsGood() const;
     bool Extract(std::string path) const;
 
+    /// Gets the files in which corrupt blocks were found when verifying, during Init or Extract.
+    const std::vector<CorruptFile>& GetCorruptFiles() const;
+
 private:
     bool Init();
     bool CheckMagic() const;
-    std::vector<u8> ReadFile(const std::string& path) const;
+    Common::PooledBuffer ReadFile(const std::string& path) const;
+    /// Gets the size of a file, or 0 if it does not exist.
+    u64 GetFileSize(const std::string& path) const;
+    /// Verifies a DIFF container when verification is enabled.
+    bool VerifyContainer(const DataContainer& container, const std::string& path) const;
     bool ExtractFile(const std::string& path, u32 index) const;
     ArchiveFormatInfo GetFormatInfo() const;
 
@@ -41,6 +52,9 @@ private:
     std::string data_path;
     const SDMCDecryptor* decryptor = nullptr;
     bool use_decryptor = true;
+    bool verify = false;
+    // Filled while extracting, which is otherwise const
+    mutable std::vector<CorruptFile> corrupt_files;
 
     friend class Archive<Extdata>;
     friend class InnerFAT<Extdata>;
@@ -4,11 +4,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <type_traits>
 #include <vector>
 #include "common/assert.h"
 #include "common/bit_field.h"
+#include "common/buffer_pool.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
@@ -211,7 +213,9 @@ protected:
         return true;
     }
 
-    bool GetFileData(std::vector<u8>& out, std::size_t index) const {
+    /// Reads a file into `out`, a std::vector<u8> or a Common::PooledBuffer (for pooled memory).
+    template <typename Container>
+    bool GetFileData(Container& out, std::size_t index) const {
         if (index >= file_entry_table.size()) {
             LOG_ERROR(Core, "Index out of bound {}", index);
             return false;
@@ -256,6 +260,12 @@ protected:
             block = block_data.v.index - 1;
         }
 
+        // Pooled buffers are not cleared, so zero the tail that a short chain leaves unwritten
+        if (file_size != 0) {
+            LOG_WARNING(Core, "FAT chain ended before the end of file (0x{:x} bytes missing)",
+                        file_size);
+            std::fill(out.begin() + written, out.end(), 0);
+        }
         return true;
     }
 
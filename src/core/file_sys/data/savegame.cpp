@@ -7,21 +7,34 @@
 
 namespace Core {
 
-Savegame::Savegame(std::vector<u8> data) {
-    is_good = Init(std::move(data));
+Savegame::Savegame(Common::PooledBuffer data, bool verify) {
+    is_good = Init(std::move(data), verify);
 }
 
 Savegame::~Savegame() = default;
 
-bool Savegame::Init(std::vector<u8> data) {
+bool Savegame::Init(Common::PooledBuffer data, bool verify) {
     if (data.empty()) {
         return false;
     }
 
     DataContainer container(std::move(data));
 
+    if (!container.IsGood()) {
+        return false;
+    }
+
+    if (verify) {
+        if (!container.Verify(corrupt_blocks)) {
+            return false;
+        }
+        if (!corrupt_blocks.empty()) {
+            LOG_WARNING(Core, "Savegame has corrupt blocks");
+        }
+    }
+
     std::vector<std::vector<u8>> partitions;
-    if (!container.IsGood() || !container.GetIVFCLevel4Data(partitions)) {
+    if (!container.GetIVFCLevel4Data(partitions)) {
         return false;
     }
 
@@ -42,8 +55,12 @@ bool Savegame::IsGood() const {
     return is_good;
 }
 
+const std::vector<CorruptBlockRange>& Savegame::GetCorruptBlocks() const {
+    return corrupt_blocks;
+}
+
 bool Savegame::ExtractFile(const std::string& path, std::size_t index) const {
-    std::vector<u8> data;
+    Common::PooledBuffer data;
     if (!GetFileData(data, index)) {
         LOG_ERROR(Core, "Could not get file data for index {}", index);
         return false;
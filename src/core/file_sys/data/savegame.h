@@ -4,26 +4,35 @@
 
 #pragma once
 
+#include <vector>
+#include "core/file_sys/data/data_container.h"
 #include "core/file_sys/data/inner_fat.hpp"
 
 namespace Core {
 
 class Savegame final : public Archive<Savegame> {
 public:
-    /// @param data Data of the DISA archive
-    explicit Savegame(std::vector<u8> data);
+    /**
+     * @param data Data of the DISA archive
+     * @param verify Whether to verify the integrity of the archive (IVFC hashes)
+     */
+    explicit Savegame(Common::PooledBuffer data, bool verify = false);
     ~Savegame();
 
     bool IsGood() const;
     bool Extract(std::string path) const;
 
+    /// Gets the corrupt blocks found when verifying the archive.
+    const std::vector<CorruptBlockRange>& GetCorruptBlocks() const;
+
 private:
-    bool Init(std::vector<u8> data);
+    bool Init(Common::PooledBuffer data, bool verify);
     bool CheckMagic() const;
     bool ExtractFile(const std::string& path, std::size_t index) const;
     ArchiveFormatInfo GetFormatInfo() const;
 
     bool is_good = false;
+    std::vector<CorruptBlockRange> corrupt_blocks;
 
     friend class Archive<Savegame>;
     friend class InnerFAT<Savegame>;
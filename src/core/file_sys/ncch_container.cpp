@@ -14,7 +14,9 @@
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
+#include "common/thread.h"
 #include "core/db/seed_db.h"
+#include "core/file_sys/block_hash.h"
 #include "core/file_sys/data/data_container.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/key/key.h"
@@ -256,7 +258,8 @@ bool NCCHContainer::Load() {
     return true;
 }
 
-bool NCCHContainer::LoadSectionExeFS(const char* name, std::vector<u8>& buffer) {
+template <typename Container>
+bool NCCHContainer::LoadSectionExeFS(const char* name, Container& buffer) {
     if (!Load()) {
         return false;
     }
@@ -296,6 +299,9 @@ bool NCCHContainer::LoadSectionExeFS(const char* name, std::vector<u8>& buffer)
     return false;
 }
 
+template bool NCCHContainer::LoadSectionExeFS(const char*, std::vector<u8>&);
+template bool NCCHContainer::LoadSectionExeFS(const char*, Common::PooledBuffer&);
+
 bool NCCHContainer::ReadProgramId(u64_le& program_id) {
     if (!Load()) {
         return false;
@@ -587,6 +593,205 @@ struct RomFSIVFCHeader {
 static_assert(sizeof(RomFSIVFCHeader) == 0x60, "Size of RomFSIVFCHeader is incorrect");
 #pragma pack(pop)
 
+bool NCCHContainer::ReadDecrypted(Common::PooledBuffer& out, std::size_t offset, std::size_t size,
+                                  const Key::AESKey& key, const Key::AESKey& ctr,
+                                  std::size_t aes_seek_pos) const {
+    out.resize(size);
+    if (!file->Seek(offset, SEEK_SET) || file->ReadBytes(out.data(), size) != size) {
+        LOG_ERROR(Core, "Could not read {:#x} bytes at {:#x}", size, offset);
+        return false;
+    }
+    if (is_encrypted) {
+        CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption aes(key.data(), key.size(), ctr.data());
+        aes.Seek(aes_seek_pos);
+        aes.ProcessData(out.data(), out.data(), out.size());
+    }
+    return true;
+}
+
+bool NCCHContainer::VerifyExeFS() const {
+    bool intact = true;
+
+    // The superblock hash covers the beginning of the ExeFS, i.e. the ExeFS header
+    Common::PooledBuffer superblock;
+    if (!ReadDecrypted(superblock, exefs_offset, ncch_header.exefs_hash_region_size * kBlockSize,
+                       primary_key, exefs_ctr, 0)) {
+        return false;
+    }
+    if (!superblock.empty() &&
+        !CryptoPP::SHA256().VerifyDigest(ncch_header.exefs_super_block_hash, superblock.data(),
+                                         superblock.size())) {
+        LOG_ERROR(Core, "ExeFS superblock hash mismatch");
+        intact = false;
+    }
+
+    // Sections are read one by one, and then hashed in parallel
+    std::array<Common::PooledBuffer, kMaxSections> sections;
+    for (unsigned section_number = 0; section_number < kMaxSections; section_number++) {
+        const auto& section = exefs_header.section[section_number];
+        if (section.offset == 0 && section.size == 0) { // not used
+            continue;
+        }
+
+        const bool is_primary =
+            strcmp(section.name, "icon") == 0 || strcmp(section.name, "banner") == 0;
+        if (!ReadDecrypted(sections[section_number],
+                           exefs_offset + sizeof(ExeFs_Header) + section.offset, section.size,
+                           is_primary ? primary_key : secondary_key, exefs_ctr,
+                           sizeof(ExeFs_Header) + section.offset)) {
+            return false;
+        }
+    }
+
+    std::array<u8, kMaxSections> good{};
+    Common::ParallelFor(kMaxSections, [this, &sections, &good](std::size_t section_number) {
+        // Hashes are stored in reverse order
+        good[section_number] = CryptoPP::SHA256().VerifyDigest(
+            exefs_header.hashes[kMaxSections - 1 - section_number],
+            sections[section_number].data(), sections[section_number].size());
+    });
+    for (unsigned section_number = 0; section_number < kMaxSections; section_number++) {
+        const auto& section = exefs_header.section[section_number];
+        if ((section.offset != 0 || section.size != 0) && !good[section_number]) {
+            LOG_ERROR(Core, "ExeFS section {} hash mismatch",
+                      std::string_view{section.name, strnlen(section.name, sizeof(section.name))});
+            intact = false;
+        }
+    }
+    return intact;
+}
+
+bool NCCHContainer::VerifyRomFS(const Common::ProgressCallback& callback) {
+    const std::size_t romfs_offset = ncch_header.romfs_offset * kBlockSize;
+    const auto Read = [this, romfs_offset](Common::PooledBuffer& out, std::size_t offset,
+                                           std::size_t size) {
+        return ReadDecrypted(out, romfs_offset + offset, size, secondary_key, romfs_ctr, offset);
+    };
+
+    const std::size_t superblock_size = ncch_header.romfs_hash_region_size * kBlockSize;
+    Common::PooledBuffer superblock;
+    if (!Read(superblock, 0, std::max(superblock_size, sizeof(RomFSIVFCHeader)))) {
+        return false;
+    }
+    RomFSIVFCHeader ivfc;
+    std::memcpy(&ivfc, superblock.data(), sizeof(ivfc));
+    if (ivfc.magic != MakeMagic('I', 'V', 'F', 'C') || ivfc.version != 0x10000) {
+        LOG_ERROR(Core, "IVFC magic/version is wrong");
+        return false;
+    }
+    for (const auto& level : ivfc.levels) {
+        if (level.block_size == 0 || level.block_size >= 32) {
+            LOG_ERROR(Core, "Invalid IVFC block size {}", level.block_size);
+            return false;
+        }
+    }
+
+    bool intact = true;
+    const auto ReportCorruptBlocks = [&intact](int level,
+                                               const std::vector<std::pair<u64, u64>>& ranges,
+                                               u64 base_offset = 0) {
+        for (const auto& [offset, size] : ranges) {
+            LOG_ERROR(Core, "RomFS IVFC level {}: corrupt data at {:#x}-{:#x}", level,
+                      base_offset + offset, base_offset + offset + size);
+            intact = false;
+        }
+    };
+
+    // The superblock hash covers the IVFC header and the master hash
+    if (superblock_size != 0 &&
+        !CryptoPP::SHA256().VerifyDigest(ncch_header.romfs_super_block_hash, superblock.data(),
+                                         superblock_size)) {
+        LOG_ERROR(Core, "RomFS superblock hash mismatch");
+        intact = false;
+    }
+
+    // Layout from ctrtool: level 3 comes first after the master hash, followed by level 1 and 2
+    const auto BlockSize = [&ivfc](std::size_t level) {
+        return std::size_t{1} << ivfc.levels[level].block_size;
+    };
+    const std::size_t level3_offset =
+        Common::AlignUp(sizeof(ivfc) + ivfc.master_hash_size, BlockSize(2));
+    const std::size_t level1_offset =
+        Common::AlignUp(level3_offset + ivfc.levels[2].size, BlockSize(0));
+    const std::size_t level2_offset =
+        Common::AlignUp(level1_offset + ivfc.levels[0].size, BlockSize(1));
+
+    Common::PooledBuffer master_hash, level1, level2;
+    if (!Read(master_hash, sizeof(ivfc), ivfc.master_hash_size) ||
+        !Read(level1, level1_offset, ivfc.levels[0].size) ||
+        !Read(level2, level2_offset, ivfc.levels[1].size)) {
+        return false;
+    }
+
+    std::vector<std::pair<u64, u64>> ranges;
+    TRY(FindCorruptBlocks(ranges, level1.data(), level1.size(), ivfc.levels[0].block_size,
+                          master_hash.data(), master_hash.size()));
+    ReportCorruptBlocks(1, ranges);
+
+    ranges.clear();
+    TRY(FindCorruptBlocks(ranges, level2.data(), level2.size(), ivfc.levels[1].block_size,
+                          level1.data(), level1.size()));
+    ReportCorruptBlocks(2, ranges);
+
+    // Level 3 holds the actual data, so it is read (and decrypted) in chunks while the previous
+    // one is being hashed.
+    constexpr std::size_t ChunkSize = 16 * 1024 * 1024;
+    const std::size_t chunk_size = Common::AlignUp(ChunkSize, BlockSize(2));
+    const std::size_t level3_size = ivfc.levels[2].size;
+    const auto ReadChunk = [&Read, level3_offset](Common::PooledBuffer& chunk, u64 offset,
+                                                  std::size_t length) {
+        return Read(chunk, level3_offset + offset, length);
+    };
+    const auto ProcessChunk = [this, &ivfc, &level2, &ranges, &ReportCorruptBlocks, level3_size,
+                               &callback](Common::PooledBuffer& chunk, u64 offset) {
+        if (aborted.exchange(false)) {
+            return false;
+        }
+
+        const std::size_t hash_offset =
+            (offset >> ivfc.levels[2].block_size) * CryptoPP::SHA256::DIGESTSIZE;
+        TRY(hash_offset <= level2.size(), LOG_ERROR(Core, "IVFC level 2 is too small"));
+
+        ranges.clear();
+        TRY(FindCorruptBlocks(ranges, chunk.data(), chunk.size(), ivfc.levels[2].block_size,
+                              level2.data() + hash_offset, level2.size() - hash_offset));
+        ReportCorruptBlocks(3, ranges, offset);
+
+        callback(offset + chunk.size(), level3_size);
+        return true;
+    };
+    if (!ProcessInChunks(level3_size, chunk_size, ReadChunk, ProcessChunk)) {
+        return false;
+    }
+    return intact;
+}
+
+bool NCCHContainer::Verify(const Common::ProgressCallback& callback) {
+    if (!Load()) {
+        return false;
+    }
+
+    bool intact = true;
+    // The ExHeader hash covers the first 0x400 bytes, not including the access descriptor
+    if (has_exheader &&
+        !CryptoPP::SHA256().VerifyDigest(ncch_header.extended_header_hash,
+                                         reinterpret_cast<const u8*>(&exheader_header), 0x400)) {
+        LOG_ERROR(Core, "ExHeader hash mismatch");
+        intact = false;
+    }
+    if (has_exefs && !VerifyExeFS()) {
+        intact = false;
+    }
+    if (has_romfs && !VerifyRomFS(callback)) {
+        intact = false;
+    }
+    return intact;
+}
+
+void NCCHContainer::AbortVerify() {
+    aborted = true;
+}
+
 std::vector<u8> LoadSharedRomFS(const std::vector<u8>& data) {
     NCCH_Header header;
     if (!CheckedMemcpy(&header, data, 0, sizeof(header))) {
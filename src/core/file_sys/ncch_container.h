@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include "common/bit_field.h"
+#include "common/buffer_pool.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/progress_callback.h"
@@ -230,9 +231,10 @@ public:
     /**
      * Reads an application ExeFS section of an NCCH file (non-compressed, primary key only)
      * @param name Name of section to read out of NCCH file
-     * @param buffer Vector to read data into
+     * @param buffer std::vector<u8> or Common::PooledBuffer to read data into
      */
-    bool LoadSectionExeFS(const char* name, std::vector<u8>& buffer);
+    template <typename Container>
+    bool LoadSectionExeFS(const char* name, Container& buffer);
 
     /**
      * Get the Program ID of the NCCH container
@@ -288,11 +290,34 @@ public:
      */
     void AbortDecryptToFile();
 
+    /**
+     * Verifies the integrity of this NCCH: the ExHeader hash, the ExeFS superblock and section
+     * hashes, and the RomFS superblock and IVFC hash tree. Blocks are hashed in parallel, and
+     * the RomFS data is streamed in chunks so that it does not need to fit in memory.
+     * Works on both encrypted and decrypted NCCHs.
+     * @param callback Progress callback, reporting the RomFS data verified.
+     * @return true if all hashes match, false otherwise
+     */
+    bool Verify(const Common::ProgressCallback& callback = [](u64, u64) {});
+
+    /**
+     * Aborts Verify.
+     */
+    void AbortVerify();
+
     NCCH_Header ncch_header;
     ExHeader_Header exheader_header;
     ExeFs_Header exefs_header;
 
 private:
+    /// Reads a region of the NCCH, decrypting it with the specified key and CTR if encrypted.
+    bool ReadDecrypted(Common::PooledBuffer& out, std::size_t offset, std::size_t size,
+                       const Key::AESKey& key, const Key::AESKey& ctr,
+                       std::size_t aes_seek_pos) const;
+
+    bool VerifyExeFS() const;
+    bool VerifyRomFS(const Common::ProgressCallback& callback);
+
     bool has_exheader = false;
     bool has_exefs = false;
     bool has_romfs = false;
@@ -316,7 +341,7 @@ private:
 
     // Used for DecryptToFile
     FileDecryptor decryptor;
-    std::atomic_bool aborted{false};
+    std::atomic_bool aborted{false}; // Also used for Verify
 
     friend class CIABuilder;
 };
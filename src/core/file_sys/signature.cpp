@@ -2,7 +2,13 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <array>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <cryptopp/rsa.h>
+#include <cryptopp/sha.h>
 #include "common/alignment.h"
 #include "common/common_funcs.h"
 #include "common/file_util.h"
@@ -40,6 +46,8 @@ static u32 GetSignatureSize(u32 type) {
     return 0;
 }
 
+Signature::Signature(Common::Arena* arena) : data(Common::ArenaAllocator<u8>{arena}) {}
+
 bool Signature::Load(const std::vector<u8>& file_data, std::size_t offset) {
     TRY_MEMCPY(&type, file_data, offset, sizeof(type));
 
@@ -69,8 +77,24 @@ std::size_t Signature::GetSize() const {
     return Common::AlignUp(data.size() + sizeof(type), 0x40);
 }
 
+using RSAVerifier = CryptoPP::RSASS<CryptoPP::PKCS1v15, CryptoPP::SHA256>::Verifier;
+using SignedDataHash = std::array<u8, CryptoPP::SHA256::DIGESTSIZE>;
+
+struct SignedDataHashHasher {
+    std::size_t operator()(const SignedDataHash& hash) const {
+        std::size_t value;
+        std::memcpy(&value, hash.data(), sizeof(value));
+        return value;
+    }
+};
+
+// Verifiers (i.e. parsed public keys) by cert name, and verification results by signed data hash.
+static std::mutex g_verification_cache_mutex;
+static std::unordered_map<std::string, std::shared_ptr<const RSAVerifier>> g_verifiers;
+static std::unordered_map<SignedDataHash, bool, SignedDataHashHasher> g_verification_results;
+
 bool Signature::Verify(const std::string& issuer,
-                       const std::function<void(CryptoPP::PK_MessageAccumulator*)>& func) const {
+                       const std::function<void(CryptoPP::HashTransformation*)>& func) const {
 
     const auto& cert = Certs::Get(issuer);
     if (type != SignatureType::Rsa2048Sha256 || cert.body.key_type != PublicKeyType::RSA_2048) {
@@ -79,13 +103,45 @@ bool Signature::Verify(const std::string& issuer,
         return false;
     }
 
-    const auto [modulus, exponent] = cert.GetRSAPublicKey();
-    CryptoPP::RSASS<CryptoPP::PKCS1v15, CryptoPP::SHA256>::Verifier verifier(modulus, exponent);
+    // The cache key covers everything that affects the result
+    SignedDataHash hash;
+    CryptoPP::SHA256 sha;
+    sha.Update(reinterpret_cast<const u8*>(issuer.c_str()), issuer.size() + 1);
+    sha.Update(reinterpret_cast<const u8*>(&type), sizeof(type));
+    sha.Update(data.data(), data.size());
+    func(&sha);
+    sha.Final(hash.data());
+
+    std::shared_ptr<const RSAVerifier> verifier;
+    {
+        std::lock_guard lock{g_verification_cache_mutex};
+        if (const auto iter = g_verification_results.find(hash);
+            iter != g_verification_results.end()) {
+            return iter->second;
+        }
+
+        auto& cached_verifier = g_verifiers[issuer];
+        if (!cached_verifier) {
+            const auto [modulus, exponent] = cert.GetRSAPublicKey();
+            cached_verifier = std::make_shared<const RSAVerifier>(modulus, exponent);
+        }
+        verifier = cached_verifier;
+    }
 
-    auto* message = verifier.NewVerificationAccumulator();
+    auto* message = verifier->NewVerificationAccumulator();
     func(message);
-    verifier.InputSignature(*message, data.data(), data.size());
-    return verifier.Verify(message);
+    verifier->InputSignature(*message, data.data(), data.size());
+    const bool result = verifier->Verify(message);
+
+    std::lock_guard lock{g_verification_cache_mutex};
+    g_verification_results.emplace(hash, result);
+    return result;
+}
+
+void Signature::ClearVerificationCache() {
+    std::lock_guard lock{g_verification_cache_mutex};
+    g_verifiers.clear();
+    g_verification_results.clear();
 }
 
 } // namespace Core
@@ -5,12 +5,14 @@
 #pragma once
 
 #include <functional>
+#include <string>
 #include <vector>
+#include "common/arena.h"
 #include "common/common_types.h"
 #include "common/swap.h"
 
 namespace CryptoPP {
-class PK_MessageAccumulator;
+class HashTransformation;
 }
 
 namespace FileUtil {
@@ -22,6 +24,9 @@ namespace Core {
 /// Consists of a signature type, a signature, and alignment to 0x40.
 class Signature {
 public:
+    Signature() = default;
+    explicit Signature(Common::Arena* arena);
+
     bool Load(const std::vector<u8>& file_data, std::size_t offset = 0);
 
     /// Writes signature to file. Includes the alignment
@@ -29,12 +34,18 @@ public:
 
     std::size_t GetSize() const;
 
-    /// Verifies the signature. Accepts a functor which should add the message to the accumulator
+    /**
+     * Verifies the signature. Accepts a functor which should add the message to the accumulator.
+     * The functor may be called more than once. Results are cached by the hash of the signed data.
+     */
     bool Verify(const std::string& issuer,
-                const std::function<void(CryptoPP::PK_MessageAccumulator*)>& func) const;
+                const std::function<void(CryptoPP::HashTransformation*)>& func) const;
+
+    /// Clears the cached public keys and verification results. Called when certs are unloaded.
+    static void ClearVerificationCache();
 
     u32_be type;
-    std::vector<u8> data;
+    Common::ArenaVector<u8> data;
 };
 
 } // namespace Core
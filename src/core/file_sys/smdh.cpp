@@ -4,6 +4,9 @@
 
 #include <cstring>
 #include <vector>
+#if defined(ARCHITECTURE_x86_64)
+#include <emmintrin.h>
+#endif
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "core/file_sys/smdh.h"
@@ -18,9 +21,12 @@ static constexpr u32 MortonInterleave(u32 x, u32 y) {
 }
 
 /**
- * Calculates the offset of the position of the pixel in Morton order
+ * Decodes an 8x8 tile of RGB565 pixels in Morton order into a linear image.
+ * @param tile The 64 pixels of the tile
+ * @param out Position of the top-left pixel of the tile in the output image
+ * @param stride Width of the output image in pixels
  */
-static inline u32 GetMortonOffset(u32 x, u32 y, u32 bytes_per_pixel) {
+static void DecodeMortonTile(const u8* tile, u16* out, u32 stride) {
     // Images are split into 8x8 tiles. Each tile is composed of four 4x4 subtiles each
     // of which is composed of four 2x2 subtiles each of which is composed of four texels.
     // Each structure is embedded into the next-bigger one in a diagonal pattern, e.g.
@@ -40,15 +46,69 @@ static inline u32 GetMortonOffset(u32 x, u32 y, u32 bytes_per_pixel) {
     // 00 01 04 05 16 17 20 21
     //
     // This pattern is what's called Z-order curve, or Morton order.
+    //
+    // Horizontally adjacent texels (x, x + 1) with an even x are always stored together, so each
+    // row is gathered as 4 pairs. Moreover, a pair of rows (y, y + 1) with an even y is entirely
+    // contained in two runs of 8 consecutive texels, at MortonInterleave(0, y) and 16 after that.
+    // In each run the pairs alternate between row y and row y + 1.
+
+#if defined(ARCHITECTURE_x86_64)
+    for (u32 y = 0; y < 8; y += 2) {
+        const u8* run = tile + MortonInterleave(0, y) * 2;
+        const __m128 a = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(run)));
+        const __m128 b =
+            _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(run + 32)));
+
+        const __m128i row0 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+        const __m128i row1 = _mm_castps_si128(_mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + y * stride), row0);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + (y + 1) * stride), row1);
+    }
+#else
+    for (u32 y = 0; y < 8; ++y) {
+        for (u32 x = 0; x < 8; x += 2) {
+            std::memcpy(out + y * stride + x, tile + MortonInterleave(x, y) * 2, 2 * sizeof(u16));
+        }
+    }
+#endif
+}
 
-    const unsigned int block_height = 8;
-    const unsigned int coarse_x = x & ~7;
-
-    u32 i = MortonInterleave(x, y);
-
-    const unsigned int offset = coarse_x * block_height;
-
-    return (i + offset) * bytes_per_pixel;
+/// Converts RGB565 pixels to 32-bit 0xAARRGGBB pixels with opaque alpha.
+static void ConvertRGB565ToARGB8888(const u16* in, u32* out, std::size_t count) {
+    std::size_t i = 0;
+
+#if defined(ARCHITECTURE_x86_64)
+    const __m128i mask5 = _mm_set1_epi16(0x1F);
+    const __m128i mask6 = _mm_set1_epi16(0x3F);
+    const __m128i alpha = _mm_set1_epi16(static_cast<short>(0xFF00));
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        const __m128i r5 = _mm_srli_epi16(pixels, 11);
+        const __m128i g6 = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask6);
+        const __m128i b5 = _mm_and_si128(pixels, mask5);
+
+        // Expand to 8 bits by replicating the high bits into the low bits
+        const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r5, 3), _mm_srli_epi16(r5, 2));
+        const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g6, 2), _mm_srli_epi16(g6, 4));
+        const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b5, 3), _mm_srli_epi16(b5, 2));
+
+        // Little endian: low half is (G << 8) | B, high half is (A << 8) | R
+        const __m128i low = _mm_or_si128(_mm_slli_epi16(g8, 8), b8);
+        const __m128i high = _mm_or_si128(alpha, r8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_unpacklo_epi16(low, high));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 4), _mm_unpackhi_epi16(low, high));
+    }
+#endif
+
+    for (; i < count; ++i) {
+        const u32 r5 = in[i] >> 11;
+        const u32 g6 = (in[i] >> 5) & 0x3F;
+        const u32 b5 = in[i] & 0x1F;
+        const u32 r8 = (r5 << 3) | (r5 >> 2);
+        const u32 g8 = (g6 << 2) | (g6 >> 4);
+        const u32 b8 = (b5 << 3) | (b5 >> 2);
+        out[i] = 0xFF000000 | (r8 << 16) | (g8 << 8) | b8;
+    }
 }
 
 bool IsValidSMDH(const std::vector<u8>& smdh_data) {
@@ -73,17 +133,24 @@ std::vector<u16> SMDH::GetIcon(bool large) const {
         icon_data = small_icon.data();
     }
 
+    // Tiles are stored row by row, each being 64 pixels
     std::vector<u16> icon(size * size);
-    for (u32 x = 0; x < size; ++x) {
-        for (u32 y = 0; y < size; ++y) {
-            u32 coarse_y = y & ~7;
-            const u8* pixel = icon_data + GetMortonOffset(x, y, 2) + coarse_y * size * 2;
-            icon[x + size * y] = (pixel[1] << 8) + pixel[0];
+    for (u32 tile_y = 0; tile_y < size; tile_y += 8) {
+        for (u32 tile_x = 0; tile_x < size; tile_x += 8) {
+            const u8* tile = icon_data + (tile_y * size + tile_x * 8) * 2;
+            DecodeMortonTile(tile, icon.data() + tile_y * size + tile_x, size);
         }
     }
     return icon;
 }
 
+std::vector<u32> SMDH::GetIconARGB8888(bool large) const {
+    const auto icon = GetIcon(large);
+    std::vector<u32> out(icon.size());
+    ConvertRGB565ToARGB8888(icon.data(), out.data(), icon.size());
+    return out;
+}
+
 std::array<u16, 0x40> SMDH::GetShortTitle(Core::SMDH::TitleLanguage language) const {
     return titles[static_cast<int>(language)].short_title;
 }
@@ -69,6 +69,13 @@ struct SMDH {
      */
     std::vector<u16> GetIcon(bool large) const;
 
+    /**
+     * Gets game icon from SMDH, converted to 32-bit 0xAARRGGBB pixels (QImage::Format_RGB32),
+     * which can be turned into pixmaps without further conversion.
+     * @param large If true, returns large icon (48x48), otherwise returns small icon (24x24)
+     */
+    std::vector<u32> GetIconARGB8888(bool large) const;
+
     /**
      * Gets the short game title from SMDH
      * @param language title language
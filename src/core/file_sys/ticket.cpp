@@ -4,6 +4,8 @@
 
 #include <cstring>
 #include <string_view>
+#include <cryptopp/aes.h>
+#include <cryptopp/modes.h>
 #include <cryptopp/rsa.h>
 #include "common/alignment.h"
 #include "common/assert.h"
@@ -15,7 +17,10 @@
 
 namespace Core {
 
-bool Ticket::Load(const std::vector<u8> file_data, std::size_t offset) {
+Ticket::Ticket(Common::Arena* arena)
+    : signature(arena), content_index(Common::ArenaAllocator<u8>{arena}) {}
+
+bool Ticket::Load(const std::vector<u8>& file_data, std::size_t offset) {
     if (!signature.Load(file_data, offset)) {
         return false;
     }
@@ -65,7 +70,7 @@ bool Ticket::Save(FileUtil::IOFile& file) const {
 bool Ticket::ValidateSignature() const {
     const auto issuer =
         Common::StringFromFixedZeroTerminatedBuffer(body.issuer.data(), body.issuer.size());
-    return signature.Verify(issuer, [this](CryptoPP::PK_MessageAccumulator* message) {
+    return signature.Verify(issuer, [this](CryptoPP::HashTransformation* message) {
         message->Update(reinterpret_cast<const u8*>(&body), sizeof(body));
         message->Update(content_index.data(), content_index.size());
     });
@@ -75,6 +80,27 @@ std::size_t Ticket::GetSize() const {
     return signature.GetSize() + sizeof(body) + content_index.size();
 }
 
+bool Ticket::GetTitleKey(Key::AESKey& out) const {
+    out = {};
+
+    Key::SelectCommonKeyIndex(body.common_key_index);
+    if (!Key::IsNormalKeyAvailable(Key::TicketCommonKey)) {
+        LOG_ERROR(Core, "Ticket common key is not available");
+        return false;
+    }
+
+    const auto ticket_key = Key::GetNormalKey(Key::TicketCommonKey);
+    Key::AESKey ctr{};
+    std::memcpy(ctr.data(), &body.title_id, 8);
+
+    CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption aes;
+    aes.SetKeyWithIV(ticket_key.data(), ticket_key.size(), ctr.data());
+
+    out = body.title_key;
+    aes.ProcessData(out.data(), out.data(), out.size());
+    return true;
+}
+
 constexpr std::string_view TicketIssuer = "Root-CA00000003-XS0000000c";
 
 // TODO: Make use of this?
@@ -102,6 +128,7 @@ Ticket BuildFakeTicket(u64 title_id) {
     body.title_id = title_id;
     body.common_key_index = 0x00;
     body.audit = 0x01;
+    ticket.content_index.resize(TicketContentIndex.size() + 0x80);
     std::memcpy(ticket.content_index.data(), TicketContentIndex.data(), TicketContentIndex.size());
     // GodMode9 by default sets all remaining 0x80 bytes to 0xFF
     std::memset(ticket.content_index.data() + TicketContentIndex.size(), 0xFF, 0x80);
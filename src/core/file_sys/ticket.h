@@ -6,10 +6,12 @@
 
 #include <array>
 #include <vector>
+#include "common/arena.h"
 #include "common/common_funcs.h"
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/file_sys/signature.h"
+#include "core/key/key.h"
 
 namespace FileUtil {
 class IOFile;
@@ -46,14 +48,26 @@ public:
     static_assert(sizeof(Body) == 0x164, "Ticket body structure size is wrong");
 #pragma pack(pop)
 
-    bool Load(const std::vector<u8> file_data, std::size_t offset = 0);
+    Ticket() = default;
+
+    /// Allocates the signature and the content index from `arena`.
+    explicit Ticket(Common::Arena* arena);
+
+    bool Load(const std::vector<u8>& file_data, std::size_t offset = 0);
     bool Save(FileUtil::IOFile& file) const;
     bool ValidateSignature() const;
     std::size_t GetSize() const;
 
+    /**
+     * Decrypts the title key with the common key selected by common_key_index.
+     * @param out Set to the decrypted title key, or zeros on failure.
+     * @return true on success, false if the common key is not available
+     */
+    bool GetTitleKey(Key::AESKey& out) const;
+
     Signature signature;
     Body body;
-    std::vector<u8> content_index;
+    Common::ArenaVector<u8> content_index;
 };
 
 Ticket BuildFakeTicket(u64 title_id);
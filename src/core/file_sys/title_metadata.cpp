@@ -18,7 +18,10 @@
 
 namespace Core {
 
-bool TitleMetadata::Load(const std::vector<u8> file_data, std::size_t offset) {
+TitleMetadata::TitleMetadata(Common::Arena* arena)
+    : signature(arena), tmd_chunks(Common::ArenaAllocator<ContentChunk>{arena}) {}
+
+bool TitleMetadata::Load(const std::vector<u8>& file_data, std::size_t offset) {
     std::size_t total_size = static_cast<std::size_t>(file_data.size() - offset);
     if (total_size < sizeof(u32_be))
         return false;
@@ -42,6 +45,7 @@ bool TitleMetadata::Load(const std::vector<u8> file_data, std::size_t offset) {
         return false;
     }
 
+    tmd_chunks.reserve(tmd_body.content_count);
     for (u16 i = 0; i < tmd_body.content_count; i++) {
         ContentChunk chunk;
 
@@ -7,6 +7,7 @@
 #include <array>
 #include <string>
 #include <vector>
+#include "common/arena.h"
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/file_sys/signature.h"
@@ -78,7 +79,12 @@ public:
 
 #pragma pack(pop)
 
-    bool Load(const std::vector<u8> file_data, std::size_t offset = 0);
+    TitleMetadata() = default;
+
+    /// Allocates the signature and the content chunks from `arena`.
+    explicit TitleMetadata(Common::Arena* arena);
+
+    bool Load(const std::vector<u8>& file_data, std::size_t offset = 0);
     bool Save(FileUtil::IOFile& file);
     bool Save(const std::string& file_path);
 
@@ -115,7 +121,7 @@ public:
 
     Signature signature;
     Body tmd_body;
-    std::vector<ContentChunk> tmd_chunks;
+    Common::ArenaVector<ContentChunk> tmd_chunks;
 };
 
 } // namespace Core
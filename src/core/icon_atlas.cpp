@@ -0,0 +1,57 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "core/icon_atlas.h"
+
+namespace Core {
+
+static u64 HashIcon(const std::vector<u32>& icon) {
+    // FNV-1a
+    u64 hash = 0xcbf29ce484222325;
+    for (const u32 pixel : icon) {
+        hash = (hash ^ pixel) * 0x100000001b3;
+    }
+    return hash;
+}
+
+u32 IconAtlas::Add(const std::vector<u32>& icon) {
+    if (icon.size() != IconPixels) {
+        LOG_ERROR(Core, "Icon has incorrect size {}", icon.size());
+        return NoIcon;
+    }
+
+    const u64 hash = HashIcon(icon);
+
+    std::lock_guard lock{mutex};
+    const auto [begin, end] = hash_to_ids.equal_range(hash);
+    for (auto iter = begin; iter != end; ++iter) {
+        const auto stored = pixels.begin() + (iter->second - 1) * IconPixels;
+        if (std::equal(icon.begin(), icon.end(), stored)) {
+            return iter->second;
+        }
+    }
+
+    pixels.insert(pixels.end(), icon.begin(), icon.end());
+    const auto id = static_cast<u32>(pixels.size() / IconPixels);
+    hash_to_ids.emplace(hash, id);
+    return id;
+}
+
+std::vector<u32> IconAtlas::Get(u32 id) const {
+    std::lock_guard lock{mutex};
+    if (id == NoIcon || id > pixels.size() / IconPixels) {
+        return {};
+    }
+    const auto begin = pixels.begin() + (id - 1) * IconPixels;
+    return std::vector<u32>(begin, begin + IconPixels);
+}
+
+std::size_t IconAtlas::Count() const {
+    std::lock_guard lock{mutex};
+    return pixels.size() / IconPixels;
+}
+
+} // namespace Core
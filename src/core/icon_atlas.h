@@ -0,0 +1,49 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/**
+ * Deduplicated store of small (24x24) title icons, kept in one contiguous buffer.
+ * Icons are referenced by IDs, which stay valid for the lifetime of the atlas, so that
+ * ContentSpecifiers do not need to carry their own copies. Thread-safe.
+ */
+class IconAtlas {
+public:
+    static constexpr std::size_t IconWidth = 24;
+    static constexpr std::size_t IconPixels = IconWidth * IconWidth;
+
+    /// ID that refers to no icon.
+    static constexpr u32 NoIcon = 0;
+
+    /**
+     * Adds an icon to the atlas. Identical icons share the same ID.
+     * @param icon 24x24 icon in 0xAARRGGBB format, as returned by SMDH::GetIconARGB8888
+     * @return ID of the icon, or NoIcon if the icon is invalid
+     */
+    u32 Add(const std::vector<u32>& icon);
+
+    /**
+     * Gets an icon by its ID.
+     * @return 24x24 icon in 0xAARRGGBB format, or empty if the ID is invalid
+     */
+    std::vector<u32> Get(u32 id) const;
+
+    /// Returns the number of unique icons stored.
+    std::size_t Count() const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<u32> pixels;                       ///< Icon with ID n is the n-th icon in here.
+    std::unordered_multimap<u64, u32> hash_to_ids; ///< Content hash -> IDs, for deduplication.
+};
+
+} // namespace Core
@@ -3,15 +3,23 @@
 // Refer to the license.txt file included.
 
 #include <cstring>
+#include <future>
+#include <iterator>
 #include <map>
-#include <regex>
+#include <utility>
 #include <cryptopp/sha.h>
+#include "common/arena.h"
 #include "common/assert.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/memory_budget.h"
+#include "common/resource_governor.h"
 #include "common/scope_exit.h"
 #include "common/string_util.h"
+#include "common/thread.h"
 #include "core/cia_builder.h"
+#include "core/cia_reader.h"
+#include "core/content_filter.h"
 #include "core/db/seed_db.h"
 #include "core/db/title_db.h"
 #include "core/file_sys/certificate.h"
@@ -24,7 +32,9 @@
 #include "core/file_sys/title_metadata.h"
 #include "core/importer.h"
 #include "core/key/key.h"
+#include "core/layout_index.h"
 #include "core/sdmc_decryptor.h"
+#include "core/tee_file.h"
 
 namespace Core {
 
@@ -33,6 +43,8 @@ SDMCImporter::SDMCImporter(const Config& config_) : config(config_) {
 }
 
 SDMCImporter::~SDMCImporter() {
+    WaitForBackgroundDBs();
+
     // Unload global DBs
     Certs::Clear();
     g_seed_db.seeds.clear();
@@ -60,23 +72,45 @@ bool SDMCImporter::Init() {
         return false;
     }
 
-    // Load and merge global DBs
+    // Load and merge global DBs. These are independent, so load them concurrently.
+    // certs.db and ticket.db are only needed for CIA building, so they are not waited for here.
     ticket_db = std::make_shared<TicketDB>();
     nand_title_db = std::make_unique<TitleDB>();
-    for (const auto& nand : config.nands) {
-        if (!nand.certs_db_path.empty()) {
-            TRY(Certs::Load(nand.certs_db_path));
+    // Failures are logged here, once, as the results are waited for many times
+    certs_db_loaded = std::async(std::launch::async, [this] {
+        for (const auto& nand : config.nands) {
+            if (!nand.certs_db_path.empty()) {
+                TRY(Certs::Load(nand.certs_db_path),
+                    LOG_ERROR(Core, "Failed to load certs.db {}", nand.certs_db_path));
+            }
         }
-        if (!nand.ticket_db_path.empty()) {
-            TRY(ticket_db->AddFromFile(nand.ticket_db_path));
+        return true;
+    });
+    ticket_db_loaded = std::async(std::launch::async, [this] {
+        for (const auto& nand : config.nands) {
+            if (!nand.ticket_db_path.empty()) {
+                TRY(ticket_db->AddFromFile(nand.ticket_db_path),
+                    LOG_ERROR(Core, "Failed to load ticket.db {}", nand.ticket_db_path));
+            }
         }
-        if (!nand.title_db_path.empty()) {
-            TRY(nand_title_db->AddFromFile(nand.title_db_path));
+        return true;
+    });
+    auto title_db_loaded = std::async(std::launch::async, [this] {
+        for (const auto& nand : config.nands) {
+            if (!nand.title_db_path.empty()) {
+                TRY(nand_title_db->AddFromFile(nand.title_db_path));
+            }
         }
-        if (!nand.seed_db_path.empty()) {
-            TRY(g_seed_db.AddFromFile(nand.seed_db_path));
+        return true;
+    });
+    auto seed_db_loaded = std::async(std::launch::async, [this] {
+        for (const auto& nand : config.nands) {
+            if (!nand.seed_db_path.empty()) {
+                TRY(g_seed_db.AddFromFile(nand.seed_db_path));
+            }
         }
-    }
+        return true;
+    });
 
     LoadSystemLanguage();
 
@@ -86,7 +120,8 @@ bool SDMCImporter::Init() {
 
     // Load SDMC Title DB
     {
-        DataContainer container(sdmc_decryptor->DecryptFile("/dbs/title.db"));
+        DataContainer container(
+            sdmc_decryptor->DecryptFile<Common::PooledBuffer>("/dbs/title.db"));
         std::vector<std::vector<u8>> data;
         if (container.IsGood() && container.GetIVFCLevel4Data(data)) {
             sdmc_title_db = std::make_unique<TitleDB>();
@@ -94,13 +129,24 @@ bool SDMCImporter::Init() {
         }
     }
 
+    // These are used for listing contents
+    TRY(title_db_loaded.get());
+    TRY(seed_db_loaded.get());
+
     FileUtil::SetUserPath(config.user_path);
     return true;
 }
 
+bool SDMCImporter::WaitForBackgroundDBs() const {
+    // The shared futures keep the results, which were already logged by the loading tasks
+    const bool certs_ok = !certs_db_loaded.valid() || certs_db_loaded.get();
+    const bool tickets_ok = !ticket_db_loaded.valid() || ticket_db_loaded.get();
+    return certs_ok && tickets_ok;
+}
+
 void SDMCImporter::LoadSystemLanguage() {
     FileUtil::IOFile file(nand_config.data_path + "sysdata/00010017/00000000", "rb");
-    Savegame save(file.GetData());
+    Savegame save(file.GetData<Common::PooledBuffer>());
     if (!save.IsGood()) {
         return;
     }
@@ -131,6 +177,11 @@ bool SDMCImporter::IsGood() const {
 }
 
 void SDMCImporter::AbortImporting() {
+    {
+        // Titles are exported when they are verified while importing
+        std::lock_guard lock{export_mutex};
+        export_aborted = true;
+    }
     sdmc_decryptor->Abort();
     file_decryptor.Abort();
 }
@@ -145,8 +196,19 @@ bool SDMCImporter::ImportContent(const ContentSpecifier& specifier,
     return true;
 }
 
+std::vector<CorruptFile> SDMCImporter::TakeCorruptData() {
+    return std::exchange(corrupt_data, {});
+}
+
 bool SDMCImporter::ImportContentImpl(const ContentSpecifier& specifier,
                                      const Common::ProgressCallback& callback) {
+    if (verify_titles && IsTitle(specifier.type)) {
+        // Verify in the same pass as importing
+        TitleOutputs outputs;
+        outputs.import = outputs.verify = true;
+        return ExportTitle(specifier, outputs, callback);
+    }
+
     switch (specifier.type) {
     case ContentType::Title:
         return ImportTitle(specifier, callback);
@@ -170,15 +232,16 @@ bool SDMCImporter::ImportContentImpl(const ContentSpecifier& specifier,
 namespace {
 
 using DecryptionFunc = std::function<bool(const std::string&, const Common::ProgressCallback&)>;
+// When skip_contents is set, only the other files (i.e. TMDs) are imported.
 bool ImportTitleGeneric(const std::string& base_path, const ContentSpecifier& specifier,
                         const Common::ProgressCallback& callback,
-                        const DecryptionFunc& decryption_func) {
+                        const DecryptionFunc& decryption_func, bool skip_contents) {
 
     Common::ProgressCallbackWrapper wrapper{specifier.maximum_size};
     const FileUtil::DirectoryEntryCallable DirectoryEntryCallback =
         [size = base_path.size(), &DirectoryEntryCallback, &callback, &decryption_func,
-         &wrapper](u64* /*num_entries_out*/, const std::string& directory,
-                   const std::string& virtual_name) {
+         &wrapper, skip_contents](u64* /*num_entries_out*/, const std::string& directory,
+                                  const std::string& virtual_name) {
             if (FileUtil::IsDirectory(directory + virtual_name + "/")) {
                 if (virtual_name == "cmd") {
                     return true; // Skip cmd (not used in Citra)
@@ -187,6 +250,10 @@ bool ImportTitleGeneric(const std::string& base_path, const ContentSpecifier& sp
                 return FileUtil::ForeachDirectoryEntry(nullptr, directory + virtual_name + "/",
                                                        DirectoryEntryCallback);
             }
+            if (skip_contents && virtual_name.size() > 4 &&
+                virtual_name.compare(virtual_name.size() - 4, 4, ".app") == 0) {
+                return true;
+            }
             const auto filepath = (directory + virtual_name).substr(size - 1);
             return decryption_func(filepath, wrapper.Wrap(callback));
         };
@@ -197,32 +264,38 @@ bool ImportTitleGeneric(const std::string& base_path, const ContentSpecifier& sp
 
 } // namespace
 
+/// Gets the root that title paths (/title/...) are relative to in Citra's user directory.
+static std::string GetCitraTitleRoot(ContentType type) {
+    if (type == ContentType::NandTitle) {
+        return FileUtil::GetUserPath(FileUtil::UserPath::NANDDir) +
+               "00000000000000000000000000000000";
+    }
+    return FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir) +
+           "Nintendo 3DS/00000000000000000000000000000000/00000000000000000000000000000000";
+}
+
 bool SDMCImporter::ImportTitle(const ContentSpecifier& specifier,
-                               const Common::ProgressCallback& callback) {
+                               const Common::ProgressCallback& callback, bool skip_contents) {
     return ImportTitleGeneric(
         config.sdmc_path, specifier, callback,
-        [this](const std::string& filepath, const Common::ProgressCallback& wrapped_callback) {
+        [this, &specifier](const std::string& filepath,
+                           const Common::ProgressCallback& wrapped_callback) {
             return sdmc_decryptor->DecryptAndWriteFile(
-                filepath,
-                FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir) +
-                    "Nintendo "
-                    "3DS/00000000000000000000000000000000/00000000000000000000000000000000" +
-                    filepath,
-                wrapped_callback);
-        });
+                filepath, GetCitraTitleRoot(specifier.type) + filepath, wrapped_callback);
+        },
+        skip_contents);
 }
 
 bool SDMCImporter::ImportNandTitle(const ContentSpecifier& specifier,
-                                   const Common::ProgressCallback& callback) {
+                                   const Common::ProgressCallback& callback, bool skip_contents) {
 
     const auto base_path = nand_config.title_path.substr(0, nand_config.title_path.size() - 6);
     return ImportTitleGeneric(
         base_path, specifier, callback,
-        [this, &base_path](const std::string& filepath,
-                           const Common::ProgressCallback& wrapped_callback) {
+        [this, &base_path, &specifier](const std::string& filepath,
+                                       const Common::ProgressCallback& wrapped_callback) {
             const auto physical_path = base_path + filepath.substr(1);
-            const auto citra_path = FileUtil::GetUserPath(FileUtil::UserPath::NANDDir) +
-                                    "00000000000000000000000000000000" + filepath;
+            const auto citra_path = GetCitraTitleRoot(specifier.type) + filepath;
             if (!FileUtil::CreateFullPath(citra_path)) {
                 LOG_ERROR(Core, "Could not create path {}", citra_path);
                 return false;
@@ -232,14 +305,20 @@ bool SDMCImporter::ImportNandTitle(const ContentSpecifier& specifier,
                 std::make_shared<FileUtil::IOFile>(physical_path, "rb"),
                 FileUtil::GetSize(physical_path),
                 std::make_shared<FileUtil::IOFile>(citra_path, "wb"), wrapped_callback);
-        });
+        },
+        skip_contents);
 }
 
 bool SDMCImporter::ImportSavegame(u64 id,
                                   [[maybe_unused]] const Common::ProgressCallback& callback) {
     const auto path = fmt::format("title/{:08x}/{:08x}/data/", (id >> 32), (id & 0xFFFFFFFF));
 
-    Savegame save(sdmc_decryptor->DecryptFile(fmt::format("/{}00000001.sav", path)));
+    const auto save_path = fmt::format("/{}00000001.sav", path);
+    const auto reservation = DataContainer::ReserveMemory(sdmc_decryptor->GetFileSize(save_path));
+    Savegame save(sdmc_decryptor->DecryptFile<Common::PooledBuffer>(save_path), verify_data);
+    if (!save.GetCorruptBlocks().empty()) {
+        corrupt_data.push_back({save_path, save.GetCorruptBlocks()});
+    }
     if (!save.IsGood()) {
         return false;
     }
@@ -254,7 +333,11 @@ bool SDMCImporter::ImportNandSavegame(u64 id,
     const auto path = fmt::format("sysdata/{:08x}/00000000", (id & 0xFFFFFFFF));
 
     FileUtil::IOFile file(nand_config.data_path + path, "rb");
-    Savegame save(file.GetData());
+    const auto reservation = DataContainer::ReserveMemory(file.GetSize());
+    Savegame save(file.GetData<Common::PooledBuffer>(), verify_data);
+    if (!save.GetCorruptBlocks().empty()) {
+        corrupt_data.push_back({nand_config.data_path + path, save.GetCorruptBlocks()});
+    }
     if (!save.IsGood()) {
         return false;
     }
@@ -267,7 +350,11 @@ bool SDMCImporter::ImportNandSavegame(u64 id,
 bool SDMCImporter::ImportExtdata(u64 id,
                                  [[maybe_unused]] const Common::ProgressCallback& callback) {
     const auto path = fmt::format("extdata/{:08x}/{:08x}/", (id >> 32), (id & 0xFFFFFFFF));
-    Extdata extdata("/" + path, *sdmc_decryptor);
+    Extdata extdata("/" + path, *sdmc_decryptor, verify_data);
+    SCOPE_EXIT({
+        const auto& files = extdata.GetCorruptFiles();
+        corrupt_data.insert(corrupt_data.end(), files.begin(), files.end());
+    });
     if (!extdata.IsGood()) {
         return false;
     }
@@ -280,7 +367,11 @@ bool SDMCImporter::ImportExtdata(u64 id,
 bool SDMCImporter::ImportNandExtdata(u64 id,
                                      [[maybe_unused]] const Common::ProgressCallback& callback) {
     const auto path = fmt::format("extdata/{:08x}/{:08x}/", (id >> 32), (id & 0xFFFFFFFF));
-    Extdata extdata(nand_config.data_path + path);
+    Extdata extdata(nand_config.data_path + path, verify_data);
+    SCOPE_EXIT({
+        const auto& files = extdata.GetCorruptFiles();
+        corrupt_data.insert(corrupt_data.end(), files.begin(), files.end());
+    });
     if (!extdata.IsGood()) {
         return false;
     }
@@ -337,56 +428,96 @@ bool SDMCImporter::ImportSysdata(u64 id,
     }
 }
 
-std::vector<ContentSpecifier> SDMCImporter::ListContent() const {
-    std::vector<ContentSpecifier> content_list;
-    ListTitle(content_list);
-    ListNandTitle(content_list);
-    ListNandSavegame(content_list);
-    ListExtdata(content_list);
-    ListSysdata(content_list);
-    return content_list;
-}
+/// Collects listed contents and hands them to a callback in batches.
+class ContentBatcher {
+public:
+    using Callback = std::function<void(std::vector<ContentSpecifier>)>;
 
-// Regex for half Title IDs
-static const std::regex title_regex{"[0-9a-f]{8}"};
+    explicit ContentBatcher(const Callback& callback_, const std::atomic_bool& cancelled_)
+        : callback(callback_), cancelled(cancelled_) {
+        batch.reserve(BatchSize);
+    }
 
-static std::string FindTMD(const std::string& path) {
-    std::string title_metadata;
-    FileUtil::ForeachDirectoryEntry(
-        nullptr, path,
-        [&title_metadata](u64* /*num_entries_out*/, const std::string& directory,
-                          const std::string& virtual_name) {
-            if (FileUtil::IsDirectory(directory + virtual_name)) {
-                return true;
-            }
+    ~ContentBatcher() {
+        Flush();
+    }
 
-            if (virtual_name.size() == 12 &&
-                virtual_name.substr(virtual_name.size() - 4) == ".tmd" &&
-                std::regex_match(virtual_name.substr(0, 8), title_regex)) {
+    void push_back(ContentSpecifier specifier) {
+        batch.push_back(std::move(specifier));
+        if (batch.size() >= BatchSize) {
+            Flush();
+        }
+    }
 
-                // We would like to find the TMD with the smallest content ID,
-                // as that would be the finalized version, not the version
-                // pending installation
-                title_metadata =
-                    title_metadata.empty() ? virtual_name : std::min(title_metadata, virtual_name);
-                return true;
-            }
+    void Flush() {
+        if (batch.empty()) {
+            return;
+        }
+        callback(std::move(batch));
+        batch.clear();
+        batch.reserve(BatchSize);
+    }
 
-            return true;
-        });
+    /// Whether listing has been cancelled. Checked between items.
+    bool IsCancelled() const {
+        return cancelled.load(std::memory_order_relaxed);
+    }
 
-    if (title_metadata.empty()) { // TMD not found
-        return {};
+private:
+    // Small enough that the first contents show up quickly, large enough to not flood the UI.
+    static constexpr std::size_t BatchSize = 16;
+
+    const Callback& callback;
+    const std::atomic_bool& cancelled;
+    std::vector<ContentSpecifier> batch;
+};
+
+std::vector<ContentSpecifier> SDMCImporter::ListContent() const {
+    std::vector<ContentSpecifier> content_list;
+    const std::atomic_bool cancelled{false};
+    ListContent(
+        [&content_list](std::vector<ContentSpecifier> batch) {
+            content_list.insert(content_list.end(), std::make_move_iterator(batch.begin()),
+                                std::make_move_iterator(batch.end()));
+        },
+        cancelled);
+    return content_list;
+}
+
+void SDMCImporter::ListContent(const std::function<void(std::vector<ContentSpecifier>)>& callback,
+                               const std::atomic_bool& cancelled) const {
+
+    ContentBatcher out(callback, cancelled);
+    Common::Arena arena;
+    // These stop early on their own when cancelled
+    ListTitle(out, arena);
+    ListNandTitle(out, arena);
+    ListNandSavegame(out);
+    if (out.IsCancelled()) {
+        return;
     }
+    ListExtdata(out);
+    ListSysdata(out);
+}
 
-    if (!FileUtil::Exists(path + title_metadata)) {
-        // Probably TMD is not directly inside, aborting.
-        return {};
+std::vector<ContentSpecifier> SDMCImporter::FilterContent(const ContentFilter& filter) const {
+    auto contents = ListContent();
+    const auto matches = ContentFilterIndex(contents).Evaluate(filter);
+
+    std::vector<ContentSpecifier> out;
+    out.reserve(matches.size());
+    for (const std::size_t i : matches) {
+        out.emplace_back(std::move(contents[i]));
     }
-    return path + title_metadata;
+    return out;
 }
 
 bool SDMCImporter::LoadTMD(ContentType type, u64 id, TitleMetadata& out) const {
+    return LoadTMD(type, id, {}, out);
+}
+
+bool SDMCImporter::LoadTMD(ContentType type, u64 id, const std::string& found_tmd_path,
+                           TitleMetadata& out) const {
     const bool is_nand = type == ContentType::NandTitle;
 
     auto& title_db = is_nand ? nand_title_db : sdmc_title_db;
@@ -402,7 +533,7 @@ bool SDMCImporter::LoadTMD(ContentType type, u64 id, TitleMetadata& out) const {
             fmt::format("{}{:08x}.tmd", physical_path, title_db->titles.at(id).tmd_content_id);
     } else {
         LOG_WARNING(Core, "Title {:016x} does not exist in title.db", id);
-        tmd_path = FindTMD(physical_path);
+        tmd_path = found_tmd_path.empty() ? FindTMD(physical_path) : found_tmd_path;
         if (tmd_path.empty()) {
             return false;
         }
@@ -424,32 +555,89 @@ bool SDMCImporter::LoadTMD(const ContentSpecifier& specifier, TitleMetadata& out
     return LoadTMD(specifier.type, specifier.id, out);
 }
 
+/// Gets the path of a content (/title/...), relative to the SDMC root or the NAND root.
+static std::string GetContentPath(const ContentSpecifier& specifier, u32 content_id) {
+    // For DLCs, there one subfolder every 256 titles, but in practice hardcoded 00000000
+    // should be fine (also matches GodMode9 behaviour)
+    const auto format_str = (specifier.id >> 32) == 0x0004008c
+                                ? "/title/{:08x}/{:08x}/content/00000000/{:08x}.app"
+                                : "/title/{:08x}/{:08x}/content/{:08x}.app";
+    return fmt::vformat(format_str, fmt::make_format_args((specifier.id >> 32),
+                                                          (specifier.id & 0xFFFFFFFF), content_id));
+}
+
 std::shared_ptr<FileUtil::IOFile> SDMCImporter::OpenContent(const ContentSpecifier& specifier,
                                                             u32 content_id) const {
+    const auto path = GetContentPath(specifier, content_id);
     if (specifier.type == ContentType::NandTitle) {
-        const auto path =
-            fmt::format("{}{:08x}/{:08x}/content/{:08x}.app", nand_config.title_path,
-                        (specifier.id >> 32), (specifier.id & 0xFFFFFFFF), content_id);
-        return std::make_shared<FileUtil::IOFile>(path, "rb");
+        // Remove the title/ from title_path
+        const auto base_path = nand_config.title_path.substr(0, nand_config.title_path.size() - 6);
+        return std::make_shared<FileUtil::IOFile>(base_path + path.substr(1), "rb");
     } else {
-        // For DLCs, there one subfolder every 256 titles, but in practice hardcoded 00000000
-        // should be fine (also matches GodMode9 behaviour)
-        const auto format_str = (specifier.id >> 32) == 0x0004008c
-                                    ? "/title/{:08x}/{:08x}/content/00000000/{:08x}.app"
-                                    : "/title/{:08x}/{:08x}/content/{:08x}.app";
-        const auto path = fmt::vformat(
-            format_str,
-            fmt::make_format_args((specifier.id >> 32), (specifier.id & 0xFFFFFFFF), content_id));
         return std::make_shared<SDMCFile>(config.sdmc_path, path, "rb");
     }
 }
 
+void SDMCImporter::PrefetchContent(const ContentSpecifier& specifier, u64 max_size,
+                                   const std::atomic_bool& cancelled) const {
+    if (!IsTitle(specifier.type)) {
+        return;
+    }
+
+    // Loading the TMD reads it as well
+    TitleMetadata tmd;
+    if (!LoadTMD(specifier, tmd)) {
+        return;
+    }
+
+    // Contents are read raw, as only the page cache matters, so no decryption is needed.
+    // The boot content comes first, as it is opened first (e.g. for the SMDH and naming).
+    std::vector<u32> content_ids{tmd.GetBootContentID()};
+    for (const auto& tmd_chunk : tmd.tmd_chunks) {
+        if (tmd_chunk.id != tmd.GetBootContentID()) {
+            content_ids.push_back(tmd_chunk.id);
+        }
+    }
+
+    auto& governor = Common::ResourceGovernor::Get();
+    constexpr std::size_t BufferSize = 1024 * 1024;
+    std::vector<u8> buffer(BufferSize);
+    for (const u32 content_id : content_ids) {
+        if (max_size == 0 || cancelled) {
+            return;
+        }
+
+        const auto path = GetContentPath(specifier, content_id);
+        const auto physical_path =
+            specifier.type == ContentType::NandTitle
+                ? nand_config.title_path.substr(0, nand_config.title_path.size() - 6) +
+                      path.substr(1)
+                : config.sdmc_path + path.substr(1);
+        FileUtil::IOFile file(physical_path, "rb");
+        if (!file) {
+            continue;
+        }
+
+        const u64 size = std::min(file.GetSize(), max_size);
+        file.Advise(0, size, FileUtil::IOFile::CacheAdvice::WillNeed);
+        for (u64 pos = 0; pos < size && !cancelled; pos += BufferSize) {
+            const auto to_read = static_cast<std::size_t>(std::min<u64>(BufferSize, size - pos));
+            governor.Acquire(to_read);
+            if (file.ReadBytes(buffer.data(), to_read) != to_read) {
+                break;
+            }
+        }
+        max_size -= size;
+    }
+}
+
 struct TitleData {
     std::string name;
     u64 extdata_id;
-    std::vector<u16> icon;
+    u32 icon_id;
 };
-static TitleData LoadTitleData(NCCHContainer& ncch, SMDH::TitleLanguage language) {
+static TitleData LoadTitleData(NCCHContainer& ncch, SMDH::TitleLanguage language,
+                               IconAtlas& icon_atlas) {
     static const std::unordered_map<u64, const char*> NamedTitles{{
         // System Applications (to avoid confusion)
         {0x00040010'2002c800, "New 3DS HOME Menu manual (JPN)"},
@@ -498,7 +686,7 @@ static TitleData LoadTitleData(NCCHContainer& ncch, SMDH::TitleLanguage language
     }
 
     // Load SMDH (for name and icon)
-    std::vector<u8> smdh_buffer;
+    Common::PooledBuffer smdh_buffer;
     if (!ncch.LoadSectionExeFS("icon", smdh_buffer)) {
         LOG_WARNING(Core, "Failed to load icon in ExeFS");
         return TitleData{std::move(title_name), extdata_id};
@@ -518,7 +706,8 @@ static TitleData LoadTitleData(NCCHContainer& ncch, SMDH::TitleLanguage language
                 Common::UTF16BufferToUTF8(smdh.GetShortTitle(SMDH::TitleLanguage::English));
         }
     }
-    return TitleData{std::move(title_name), extdata_id, smdh.GetIcon(false)};
+    return TitleData{std::move(title_name), extdata_id,
+                     icon_atlas.Add(smdh.GetIconARGB8888(false))};
 }
 
 static std::string NormalizeFilename(std::string filename) {
@@ -551,7 +740,7 @@ static std::string GetTitleFileName(NCCHContainer& ncch) {
     u64 program_id{};
     ncch.ReadProgramId(program_id);
 
-    std::vector<u8> smdh_buffer;
+    Common::PooledBuffer smdh_buffer;
     if (!ncch.LoadSectionExeFS("icon", smdh_buffer) || smdh_buffer.size() != sizeof(SMDH)) {
         LOG_WARNING(Core, "Failed to load icon in ExeFS or size incorrect");
         return NormalizeFilename(
@@ -613,6 +802,7 @@ bool SDMCImporter::CanBuildLegitCIA(const ContentSpecifier& specifier) const {
     if (!IsTitle(specifier.type)) {
         return false;
     }
+    WaitForBackgroundDBs();
 
     TitleMetadata tmd;
     if (!LoadTMD(specifier.type, specifier.id, tmd)) {
@@ -625,10 +815,31 @@ bool SDMCImporter::CanBuildLegitCIA(const ContentSpecifier& specifier) const {
     return true;
 }
 
+std::vector<bool> SDMCImporter::CanBuildLegitCIA(
+    const std::vector<ContentSpecifier>& specifiers) const {
+
+    WaitForBackgroundDBs();
+
+    // Elements of std::vector<bool> cannot be written to concurrently
+    std::vector<u8> results(specifiers.size());
+    Common::ParallelFor(specifiers.size(), [this, &specifiers, &results](std::size_t i) {
+        results[i] = CanBuildLegitCIA(specifiers[i]);
+    });
+    return std::vector<bool>(results.begin(), results.end());
+}
+
+// File extensions of the CIA build types, used for automatic filenames
+constexpr std::array<std::string_view, 3> BuildTypeExts{{
+    "standard.cia",
+    "piratelegit.cia",
+    "legit.cia",
+}};
+
 bool SDMCImporter::BuildCIA(CIABuildType build_type, const ContentSpecifier& specifier,
                             std::string destination, const Common::ProgressCallback& callback,
                             bool auto_filename) {
 
+    WaitForBackgroundDBs();
     if (!Certs::IsLoaded()) {
         LOG_ERROR(Core, "Missing certs");
         return false;
@@ -648,17 +859,12 @@ bool SDMCImporter::BuildCIA(CIABuildType build_type, const ContentSpecifier& spe
     if (destination.back() == '/' || destination.back() == '\\') {
         auto_filename = true;
     }
-    static constexpr std::array<std::string_view, 3> BuildTypeExts{{
-        "standard.cia",
-        "piratelegit.cia",
-        "legit.cia",
-    }};
     if (auto_filename) {
         if (destination.back() != '/' && destination.back() != '\\') {
             destination.push_back('/');
         }
         auto file = OpenContent(specifier, tmd.GetBootContentID());
-        if (!file) {
+        if (!file->IsOpen()) {
             LOG_ERROR(Core, "Could not open boot content");
             return false;
         }
@@ -680,9 +886,10 @@ bool SDMCImporter::BuildCIA(CIABuildType build_type, const ContentSpecifier& spe
         return false;
     }
 
+    std::vector<u32> content_ids;
     for (const auto& tmd_chunk : tmd.tmd_chunks) {
         auto file = OpenContent(specifier, tmd_chunk.id);
-        if (!file) {
+        if (!file->IsOpen()) {
             if (static_cast<u16>(tmd_chunk.type) & 0x4000) { // optional
                 continue;
             }
@@ -691,6 +898,11 @@ bool SDMCImporter::BuildCIA(CIABuildType build_type, const ContentSpecifier& spe
             return false;
         }
 
+        if (build_type != CIABuildType::Standard) { // Added all at once below
+            content_ids.push_back(tmd_chunk.id);
+            continue;
+        }
+
         NCCHContainer ncch(std::move(file));
         ret = cia_builder->AddContent(tmd_chunk.id, ncch);
         if (!ret) {
@@ -698,10 +910,59 @@ bool SDMCImporter::BuildCIA(CIABuildType build_type, const ContentSpecifier& spe
         }
     }
 
+    // Contents of Legit and PirateLegit CIAs are only encrypted, which is done on several
+    // contents in parallel
+    if (build_type != CIABuildType::Standard) {
+        ret = cia_builder->AddContents(content_ids, [this, &specifier](u32 content_id) {
+            return OpenContent(specifier, content_id);
+        });
+        if (!ret) {
+            return false;
+        }
+    }
+
     ret = cia_builder->Finalize();
     return ret;
 }
 
+bool SDMCImporter::StreamCIA(CIABuildType build_type, const ContentSpecifier& specifier,
+                             std::shared_ptr<FileUtil::IOFile> destination,
+                             const Common::ProgressCallback& callback) {
+
+    WaitForBackgroundDBs();
+    if (!Certs::IsLoaded()) {
+        LOG_ERROR(Core, "Missing certs");
+        return false;
+    }
+
+    if (!IsTitle(specifier.type)) {
+        LOG_ERROR(Core, "Unsupported specifier type {}", static_cast<int>(specifier.type));
+        return false;
+    }
+
+    TitleMetadata tmd;
+    if (!LoadTMD(specifier.type, specifier.id, tmd)) {
+        return false;
+    }
+
+    std::vector<u32> content_ids;
+    for (const auto& tmd_chunk : tmd.tmd_chunks) {
+        if (!OpenContent(specifier, tmd_chunk.id)->IsOpen()) {
+            if (static_cast<u16>(tmd_chunk.type) & 0x4000) { // optional
+                continue;
+            }
+            LOG_ERROR(Core, "Could not open content {:08x}", static_cast<u32>(tmd_chunk.id));
+            return false;
+        }
+        content_ids.push_back(tmd_chunk.id);
+    }
+
+    return cia_builder->BuildSequential(
+        build_type, std::move(destination), std::move(tmd), content_ids,
+        [this, &specifier](u32 content_id) { return OpenContent(specifier, content_id); },
+        specifier.maximum_size, callback);
+}
+
 void SDMCImporter::AbortBuildCIA() {
     cia_builder->Abort();
 }
@@ -745,7 +1006,7 @@ bool SDMCImporter::CheckTitleContents(const ContentSpecifier& specifier,
 
     for (const auto& tmd_chunk : tmd.tmd_chunks) {
         auto file = OpenContent(specifier, tmd_chunk.id);
-        if (!file) {
+        if (!file->IsOpen()) {
             if (static_cast<u16>(tmd_chunk.type) & 0x4000) { // optional
                 continue;
             }
@@ -768,228 +1029,426 @@ bool SDMCImporter::CheckTitleContents(const ContentSpecifier& specifier,
     return true;
 }
 
-// Add a certain amount to the titles' maximum sizes, so that they are always larger than CIA sizes
-constexpr u64 TitleSizeAllowance = 0xA000;
+bool SDMCImporter::ExportTitle(const ContentSpecifier& specifier, const TitleOutputs& outputs,
+                               const Common::ProgressCallback& callback) {
 
-void SDMCImporter::ListTitle(std::vector<ContentSpecifier>& out) const {
-    const auto ProcessDirectory = [this, &out, &sdmc_path = config.sdmc_path](u64 high_id) {
-        FileUtil::ForeachDirectoryEntry(
-            nullptr, fmt::format("{}title/{:08x}/", sdmc_path, high_id),
-            [this, &sdmc_path, high_id, &out](u64* /*num_entries_out*/,
-                                              const std::string& directory,
-                                              const std::string& virtual_name) {
-                if (!FileUtil::IsDirectory(directory + virtual_name + "/")) {
-                    return true;
-                }
+    {
+        std::lock_guard lock{export_mutex};
+        export_aborted = false;
+    }
+    const auto is_aborted = [this] {
+        std::lock_guard lock{export_mutex};
+        return export_aborted;
+    };
 
-                if (!std::regex_match(virtual_name, title_regex)) {
-                    return true;
-                }
+    if (!IsTitle(specifier.type)) {
+        LOG_ERROR(Core, "Unsupported specifier type {}", static_cast<int>(specifier.type));
+        return false;
+    }
+    // not an Application
+    if (!outputs.cxi_path.empty() &&
+        (specifier.type != ContentType::Title || (specifier.id >> 32) != 0x00040000)) {
+        LOG_ERROR(Core, "Cannot dump CXI for specifier (id={:016x})", specifier.id);
+        return false;
+    }
+    if (!outputs.cia_path.empty()) {
+        WaitForBackgroundDBs();
+        if (!Certs::IsLoaded()) {
+            LOG_ERROR(Core, "Missing certs");
+            return false;
+        }
+    }
 
-                const u64 id = (high_id << 32) + std::stoull(virtual_name, nullptr, 16);
-                const auto citra_path = fmt::format(
-                    "{}Nintendo "
-                    "3DS/00000000000000000000000000000000/00000000000000000000000000000000/title/"
-                    "{:08x}/{}/",
-                    FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir), high_id, virtual_name);
-
-                if (FileUtil::Exists(directory + virtual_name + "/content/")) {
-                    do {
-                        TitleMetadata tmd;
-                        if (!LoadTMD(ContentType::Title, id, tmd)) {
-                            out.push_back({ContentType::Title, id,
-                                           FileUtil::Exists(citra_path + "content/"),
-                                           FileUtil::GetDirectoryTreeSize(directory + virtual_name +
-                                                                          "/content/")});
-                            break;
-                        }
-
-                        const auto boot_content_path =
-                            fmt::format("/title/{:08x}/{}/content/{:08x}.app", high_id,
-                                        virtual_name, tmd.GetBootContentID());
-                        NCCHContainer ncch(
-                            std::make_shared<SDMCFile>(sdmc_path, boot_content_path, "rb"));
-                        if (!ncch.Load()) {
-                            LOG_WARNING(Core, "Could not load NCCH {}", boot_content_path);
-                            out.push_back({ContentType::Title, id,
-                                           FileUtil::Exists(citra_path + "content/"),
-                                           FileUtil::GetDirectoryTreeSize(directory + virtual_name +
-                                                                          "/content/")});
-                            break;
-                        }
-
-                        const auto& [name, extdata_id, icon] = LoadTitleData(ncch, system_language);
-                        const auto size =
-                            FileUtil::GetDirectoryTreeSize(directory + virtual_name + "/content/") +
-                            TitleSizeAllowance;
-                        out.push_back({ContentType::Title, id,
-                                       FileUtil::Exists(citra_path + "content/"), size, name,
-                                       extdata_id, icon});
-                    } while (false);
-                }
+    // Load TMD
+    TitleMetadata tmd;
+    if (!LoadTMD(specifier.type, specifier.id, tmd)) {
+        return false;
+    }
 
-                if (high_id != 0x00040000) { // Check savegame only for applications
-                    return true;
-                }
-                if (FileUtil::Exists(directory + virtual_name + "/data/")) {
-                    // Savegames can be uninitialized.
-                    // TODO: Is there a better way of checking this other than performing the
-                    // decryption? (Very costy)
-                    DataContainer container(sdmc_decryptor->DecryptFile(
-                        fmt::format("/title/{:08x}/{}/data/00000001.sav", high_id, virtual_name)));
-                    if (!container.IsGood()) {
-                        return true;
-                    }
-
-                    out.push_back(
-                        {ContentType::Savegame, id, FileUtil::Exists(citra_path + "data/"),
-                         FileUtil::GetDirectoryTreeSize(directory + virtual_name + "/data/")});
-                }
-                return true;
-            });
+    auto cia_path = outputs.cia_path;
+    auto cxi_path = outputs.cxi_path;
+    const auto is_directory = [](const std::string& path) {
+        return !path.empty() && (path.back() == '/' || path.back() == '\\');
     };
+    if (is_directory(cia_path) || is_directory(cxi_path)) {
+        NCCHContainer ncch(OpenContent(specifier, tmd.GetBootContentID()));
+        const auto title_name = GetTitleFileName(ncch);
+        if (is_directory(cia_path)) {
+            cia_path.append(
+                fmt::format("{} (v{}).{}", title_name, tmd.GetTitleVersionString(),
+                            BuildTypeExts.at(static_cast<std::size_t>(outputs.cia_type))));
+        }
+        if (is_directory(cxi_path)) {
+            cxi_path.append(title_name).append(".cxi");
+        }
+    }
 
-    ProcessDirectory(0x00040000);
-    ProcessDirectory(0x0004000e);
-    ProcessDirectory(0x0004008c);
-}
+    bool ret = false;
+    SCOPE_EXIT({
+        if (!cia_path.empty()) {
+            cia_builder->Cleanup();
+            std::lock_guard lock{export_mutex};
+            verify_cia_reader.reset();
+        }
+        if (!ret) { // Remove borked outputs
+            if (outputs.import) {
+                DeleteContent(specifier);
+            }
+            if (!cia_path.empty()) {
+                FileUtil::Delete(cia_path);
+            }
+            if (!cxi_path.empty()) {
+                FileUtil::Delete(cxi_path);
+            }
+        }
+    });
 
-// TODO: Simplify.
-void SDMCImporter::ListNandTitle(std::vector<ContentSpecifier>& out) const {
-    const auto ProcessDirectory = [this, &out, &title_path = nand_config.title_path](u64 high_id) {
-        FileUtil::ForeachDirectoryEntry(
-            nullptr, fmt::format("{}{:08x}/", title_path, high_id),
-            [this, high_id, &out](u64* /*num_entries_out*/, const std::string& directory,
-                                  const std::string& virtual_name) {
-                if (!FileUtil::IsDirectory(directory + virtual_name + "/")) {
-                    return true;
-                }
+    if (!cia_path.empty() && !cia_builder->Init(outputs.cia_type, cia_path, tmd,
+                                                specifier.maximum_size, callback)) {
+        return false;
+    }
 
-                if (!std::regex_match(virtual_name, title_regex)) {
-                    return true;
-                }
+    std::shared_ptr<FileUtil::IOFile> cxi_file;
+    if (!cxi_path.empty()) {
+        if (!FileUtil::CreateFullPath(cxi_path)) {
+            LOG_ERROR(Core, "Failed to create path {}", cxi_path);
+            return false;
+        }
+        cxi_file = std::make_shared<FileUtil::IOFile>(cxi_path, "wb");
+    }
 
-                const u64 id = (high_id << 32) + std::stoull(virtual_name, nullptr, 16);
-                const auto citra_path = fmt::format(
-                    "{}00000000000000000000000000000000/title/{:08x}/{}/",
-                    FileUtil::GetUserPath(FileUtil::UserPath::NANDDir), high_id, virtual_name);
-
-                const auto content_path = directory + virtual_name + "/content/";
-                if (FileUtil::Exists(content_path)) {
-                    do {
-                        TitleMetadata tmd;
-                        if (!LoadTMD(ContentType::NandTitle, id, tmd)) {
-                            out.push_back({ContentType::NandTitle, id,
-                                           FileUtil::Exists(citra_path + "content/"),
-                                           FileUtil::GetDirectoryTreeSize(content_path)});
-                            break;
-                        }
-
-                        const auto boot_content_path =
-                            fmt::format("{}{:08x}.app", content_path, tmd.GetBootContentID());
-                        NCCHContainer ncch(
-                            std::make_shared<FileUtil::IOFile>(boot_content_path, "rb"));
-                        if (!ncch.Load()) {
-                            LOG_WARNING(Core, "Could not load NCCH {}", boot_content_path);
-                            break;
-                        }
-
-                        const auto& [name, extdata_id, icon] = LoadTitleData(ncch, system_language);
-                        const auto size =
-                            FileUtil::GetDirectoryTreeSize(directory + virtual_name + "/content/") +
-                            TitleSizeAllowance;
-                        out.push_back({ContentType::NandTitle, id,
-                                       FileUtil::Exists(citra_path + "content/"), size, name,
-                                       extdata_id, icon});
-                    } while (false);
-                }
-                return true;
-            });
-    };
+    // Import the TMDs. The contents are imported below.
+    if (outputs.import) {
+        const auto import_tmd = specifier.type == ContentType::NandTitle
+                                    ? &SDMCImporter::ImportNandTitle
+                                    : &SDMCImporter::ImportTitle;
+        if (!(this->*import_tmd)(specifier, [](u64, u64) {}, true)) {
+            return false;
+        }
+    }
 
-    ProcessDirectory(0x00040010);
-    ProcessDirectory(0x0004001b);
-    ProcessDirectory(0x00040030);
-    ProcessDirectory(0x0004009b);
-    ProcessDirectory(0x000400db);
-    ProcessDirectory(0x00040130);
-    ProcessDirectory(0x00040138);
-}
+    Common::ProgressCallbackWrapper wrapper{specifier.maximum_size};
+    for (const auto& tmd_chunk : tmd.tmd_chunks) {
+        if (is_aborted()) {
+            return false;
+        }
+        auto file = OpenContent(specifier, tmd_chunk.id);
+        if (!file->IsOpen()) {
+            if (static_cast<u16>(tmd_chunk.type) & 0x4000) { // optional
+                continue;
+            }
+            LOG_ERROR(Core, "Could not open content {:08x}", static_cast<u32>(tmd_chunk.id));
+            return false;
+        }
+        // When a CIA is built, it reports the progress of the contents itself.
+        const auto content_callback =
+            cia_path.empty() ? wrapper.Wrap(callback) : Common::ProgressCallback{[](u64, u64) {}};
 
-void SDMCImporter::ListNandSavegame(std::vector<ContentSpecifier>& out) const {
-    FileUtil::ForeachDirectoryEntry(
-        nullptr, fmt::format("{}sysdata/", nand_config.data_path),
-        [&out](u64* /*num_entries_out*/, const std::string& directory,
-               const std::string& virtual_name) {
-            if (!FileUtil::IsDirectory(directory + virtual_name + "/")) {
-                return true;
+        // Outputs of the content as is (SD decrypted)
+        std::vector<std::shared_ptr<FileUtil::IOFile>> sinks;
+        if (outputs.import) {
+            const auto citra_path =
+                GetCitraTitleRoot(specifier.type) + GetContentPath(specifier, tmd_chunk.id);
+            if (!FileUtil::CreateFullPath(citra_path)) {
+                LOG_ERROR(Core, "Could not create path {}", citra_path);
+                return false;
+            }
+            sinks.emplace_back(std::make_shared<FileUtil::IOFile>(citra_path, "wb"));
+        }
+        std::shared_ptr<HashOnlyFile> hash_file;
+        if (outputs.verify) {
+            hash_file = std::make_shared<HashOnlyFile>();
+            sinks.emplace_back(hash_file);
+        }
+        auto raw_file = std::make_shared<TeeFile>(std::move(sinks));
+
+        bool dump_cxi = cxi_file && tmd_chunk.id == tmd.GetBootContentID();
+        if (!cia_path.empty() || dump_cxi) {
+            // The NCCH is read through a ForwardingFile, so that the content is written to the
+            // other outputs while it is being decrypted.
+            const auto forwarding_file =
+                std::make_shared<ForwardingFile>(std::move(file), std::move(raw_file));
+            {
+                std::lock_guard lock{export_mutex};
+                if (export_aborted) {
+                    return false;
+                }
+                dump_cxi_ncch = std::make_unique<NCCHContainer>(forwarding_file);
             }
 
-            if (!std::regex_match(virtual_name, title_regex)) {
-                return true;
+            if (!cia_path.empty()) {
+                // Standard CIAs contain the decrypted NCCH, which is the CXI as well.
+                const bool tee_cxi = dump_cxi && outputs.cia_type == CIABuildType::Standard;
+                if (!cia_builder->AddContent(tmd_chunk.id, *dump_cxi_ncch,
+                                             tee_cxi ? cxi_file : nullptr)) {
+                    return false;
+                }
+                dump_cxi = dump_cxi && !tee_cxi;
+            }
+            if (dump_cxi && !dump_cxi_ncch->DecryptToFile(cxi_file, content_callback)) {
+                return false;
+            }
+            if (!forwarding_file->Finish()) {
+                LOG_ERROR(Core, "Could not write content {:08x}", static_cast<u32>(tmd_chunk.id));
+                return false;
+            }
+        } else {
+            // An abort that lands before the decryptor is running is lost, so check again on
+            // progress, which is first reported once it runs.
+            const auto decrypt_callback = [this, &is_aborted, &content_callback](u64 current,
+                                                                                 u64 total) {
+                if (is_aborted()) {
+                    file_decryptor.Abort();
+                }
+                content_callback(current, total);
+            };
+            const auto size = file->GetSize();
+            if (!file_decryptor.CryptAndWriteFile(std::move(file), size, std::move(raw_file),
+                                                  decrypt_callback)) {
+                return false;
             }
+        }
 
-            const auto path = directory + virtual_name + "/00000000";
+        if (hash_file && !hash_file->VerifyHash(tmd_chunk.hash.data())) {
+            LOG_ERROR(Core, "Hash dismatch for content {:08x}", static_cast<u32>(tmd_chunk.id));
+            return false;
+        }
+    }
 
-            // Read the file to test.
-            FileUtil::IOFile file(path, "rb");
-            std::vector<u8> data = file.GetData();
-            if (data.empty()) {
-                LOG_ERROR(Core, "Could not read from {}", path);
+    // Check the hashes within the dumped CXI as well
+    if (outputs.verify && cxi_file) {
+        cxi_file.reset();
+        {
+            std::lock_guard lock{export_mutex};
+            if (export_aborted) {
                 return false;
             }
+            dump_cxi_ncch = std::make_unique<NCCHContainer>(
+                std::make_shared<FileUtil::IOFile>(cxi_path, "rb"));
+        }
+        if (!dump_cxi_ncch->Verify()) {
+            LOG_ERROR(Core, "Dumped CXI {} is corrupted", cxi_path);
+            return false;
+        }
+    }
 
-            DataContainer container(std::move(data));
-            if (!container.IsGood()) {
-                return true;
+    if (!cia_path.empty() && !cia_builder->Finalize()) {
+        return false;
+    }
+
+    // Read the built CIA back to check its structure and every content in it
+    if (outputs.verify && !cia_path.empty()) {
+        cia_builder->Cleanup();
+        {
+            std::lock_guard lock{export_mutex};
+            if (export_aborted) {
+                return false;
             }
+            verify_cia_reader =
+                std::make_unique<CIAReader>(std::make_shared<FileUtil::IOFile>(cia_path, "rb"));
+        }
+        if (!verify_cia_reader->Verify()) {
+            LOG_ERROR(Core, "Built CIA {} is corrupted", cia_path);
+            return false;
+        }
+    }
 
-            const u64 id = std::stoull(virtual_name, nullptr, 16);
-            const auto citra_path =
-                fmt::format("{}data/00000000000000000000000000000000/sysdata/{}/00000000",
-                            FileUtil::GetUserPath(FileUtil::UserPath::NANDDir), virtual_name);
-            out.push_back({ContentType::NandSavegame, id, FileUtil::Exists(citra_path),
-                           FileUtil::GetSize(path)});
-            return true;
-        });
+    ret = true;
+    callback(specifier.maximum_size, specifier.maximum_size);
+    return true;
 }
 
-void SDMCImporter::ListExtdata(std::vector<ContentSpecifier>& out) const {
-    const auto ProcessDirectory = [&out](u64 id_high, ContentType type, const std::string& path,
-                                         const std::string& citra_path_template) {
-        FileUtil::ForeachDirectoryEntry(
-            nullptr, path,
-            [&out, id_high, type, citra_path_template](u64* /*num_entries_out*/,
-                                                       const std::string& directory,
-                                                       const std::string& virtual_name) {
-                if (!FileUtil::IsDirectory(directory + virtual_name + "/")) {
-                    return true;
+void SDMCImporter::AbortExportTitle() {
+    std::lock_guard lock{export_mutex};
+    export_aborted = true;
+    sdmc_decryptor->Abort();
+    file_decryptor.Abort();
+    cia_builder->Abort();
+    if (dump_cxi_ncch) {
+        dump_cxi_ncch->AbortDecryptToFile();
+        dump_cxi_ncch->AbortVerify();
+    }
+    if (verify_cia_reader) {
+        verify_cia_reader->Abort();
+    }
+}
+
+// Add a certain amount to the titles' maximum sizes, so that they are always larger than CIA sizes
+constexpr u64 TitleSizeAllowance = 0xA000;
+
+void SDMCImporter::ListTitle(ContentBatcher& out, Common::Arena& arena) const {
+    const std::vector<u32> high_ids{0x00040000, 0x0004000e, 0x0004008c};
+
+    LayoutIndex layout;
+    layout.ScanTitles(config.sdmc_path + "title/", high_ids, true);
+    LayoutIndex citra_layout;
+    citra_layout.ScanTitles(
+        FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir) +
+            "Nintendo "
+            "3DS/00000000000000000000000000000000/00000000000000000000000000000000/title/",
+        high_ids, false);
+
+    for (const auto& [id, title] : layout.GetTitles()) {
+        if (out.IsCancelled()) {
+            return;
+        }
+        arena.Reset();
+
+        const auto* citra_title = citra_layout.FindTitle(id);
+        if (title.has_content) {
+            const bool exists = citra_title && citra_title->has_content;
+            do {
+                TitleMetadata tmd{&arena};
+                if (!LoadTMD(ContentType::Title, id, title.tmd_path, tmd)) {
+                    out.push_back({ContentType::Title, id, exists, title.content_size});
+                    break;
                 }
 
-                if (!std::regex_match(virtual_name, title_regex)) {
-                    return true;
+                const auto boot_content_path =
+                    fmt::format("/title/{:08x}/{:08x}/content/{:08x}.app", (id >> 32),
+                                (id & 0xFFFFFFFF), tmd.GetBootContentID());
+                NCCHContainer ncch(std::allocate_shared<SDMCFile>(
+                    Common::ArenaAllocator<SDMCFile>{&arena}, config.sdmc_path, boot_content_path,
+                    "rb"));
+                if (!ncch.Load()) {
+                    LOG_WARNING(Core, "Could not load NCCH {}", boot_content_path);
+                    out.push_back({ContentType::Title, id, exists, title.content_size});
+                    break;
                 }
 
-                const u64 id = std::stoull(virtual_name, nullptr, 16);
-                const auto citra_path =
-                    fmt::vformat(citra_path_template, fmt::make_format_args(virtual_name));
-                out.push_back({type, (id_high << 32) | id, FileUtil::Exists(citra_path),
-                               FileUtil::GetDirectoryTreeSize(directory + virtual_name + "/")});
-                return true;
-            });
+                const auto& [name, extdata_id, icon_id] =
+                    LoadTitleData(ncch, system_language, icon_atlas);
+                out.push_back({ContentType::Title, id, exists,
+                               title.content_size + TitleSizeAllowance, name, extdata_id,
+                               icon_id});
+            } while (false);
+        }
+
+        if ((id >> 32) != 0x00040000) { // Check savegame only for applications
+            continue;
+        }
+        if (title.has_data) {
+            // Savegames can be uninitialized.
+            // TODO: Is there a better way of checking this other than performing the
+            // decryption? (Very costy)
+            const auto save_path = fmt::format("/title/{:08x}/{:08x}/data/00000001.sav",
+                                               (id >> 32), (id & 0xFFFFFFFF));
+            // The container is only loaded, not unwrapped
+            const auto reservation =
+                Common::MemoryBudget::Get().Reserve(sdmc_decryptor->GetFileSize(save_path));
+            DataContainer container(
+                sdmc_decryptor->DecryptFile<Common::PooledBuffer>(save_path));
+            if (!container.IsGood()) {
+                continue;
+            }
+
+            out.push_back({ContentType::Savegame, id, citra_title && citra_title->has_data,
+                           title.data_size});
+        }
+    }
+}
+
+// TODO: Simplify.
+void SDMCImporter::ListNandTitle(ContentBatcher& out, Common::Arena& arena) const {
+    const std::vector<u32> high_ids{0x00040010, 0x0004001b, 0x00040030, 0x0004009b,
+                                    0x000400db, 0x00040130, 0x00040138};
+
+    LayoutIndex layout;
+    layout.ScanTitles(nand_config.title_path, high_ids, true);
+    LayoutIndex citra_layout;
+    citra_layout.ScanTitles(FileUtil::GetUserPath(FileUtil::UserPath::NANDDir) +
+                                "00000000000000000000000000000000/title/",
+                            high_ids, false);
+
+    for (const auto& [id, title] : layout.GetTitles()) {
+        if (out.IsCancelled()) {
+            return;
+        }
+        if (!title.has_content) {
+            continue;
+        }
+        arena.Reset();
+
+        const auto* citra_title = citra_layout.FindTitle(id);
+        const bool exists = citra_title && citra_title->has_content;
+
+        TitleMetadata tmd{&arena};
+        if (!LoadTMD(ContentType::NandTitle, id, title.tmd_path, tmd)) {
+            out.push_back({ContentType::NandTitle, id, exists, title.content_size});
+            continue;
+        }
+
+        const auto boot_content_path =
+            fmt::format("{}{:08x}/{:08x}/content/{:08x}.app", nand_config.title_path, (id >> 32),
+                        (id & 0xFFFFFFFF), tmd.GetBootContentID());
+        NCCHContainer ncch(std::allocate_shared<FileUtil::IOFile>(
+            Common::ArenaAllocator<FileUtil::IOFile>{&arena}, boot_content_path, "rb"));
+        if (!ncch.Load()) {
+            LOG_WARNING(Core, "Could not load NCCH {}", boot_content_path);
+            continue;
+        }
+
+        const auto& [name, extdata_id, icon_id] = LoadTitleData(ncch, system_language, icon_atlas);
+        out.push_back({ContentType::NandTitle, id, exists, title.content_size + TitleSizeAllowance,
+                       name, extdata_id, icon_id});
+    }
+}
+
+void SDMCImporter::ListNandSavegame(ContentBatcher& out) const {
+    LayoutIndex layout;
+    layout.ScanArchives(nand_config.data_path + "sysdata/", 0, "00000000", true);
+    LayoutIndex citra_layout;
+    citra_layout.ScanArchives(FileUtil::GetUserPath(FileUtil::UserPath::NANDDir) +
+                                  "data/00000000000000000000000000000000/sysdata/",
+                              0, "00000000", false);
+
+    for (const auto& [id, archive] : layout.GetArchives()) {
+        if (out.IsCancelled()) {
+            return;
+        }
+        // Read the file to test.
+        FileUtil::IOFile file(archive.path, "rb");
+        const auto reservation = Common::MemoryBudget::Get().Reserve(file.GetSize());
+        auto data = file.GetData<Common::PooledBuffer>();
+        if (data.empty()) {
+            LOG_ERROR(Core, "Could not read from {}", archive.path);
+            return;
+        }
+
+        DataContainer container(std::move(data));
+        if (!container.IsGood()) {
+            continue;
+        }
+
+        out.push_back({ContentType::NandSavegame, id, citra_layout.FindArchive(id) != nullptr,
+                       archive.size});
+    }
+}
+
+void SDMCImporter::ListExtdata(ContentBatcher& out) const {
+    const auto ProcessDirectory = [&out](u32 id_high, ContentType type, const std::string& path,
+                                         const std::string& citra_path) {
+        LayoutIndex layout;
+        layout.ScanArchives(path, id_high, {}, true);
+        LayoutIndex citra_layout;
+        citra_layout.ScanArchives(citra_path, id_high, {}, false);
+
+        for (const auto& [id, archive] : layout.GetArchives()) {
+            out.push_back({type, id, citra_layout.FindArchive(id) != nullptr, archive.size});
+        }
     };
     ProcessDirectory(0, ContentType::Extdata, fmt::format("{}extdata/00000000/", config.sdmc_path),
                      FileUtil::GetUserPath(FileUtil::UserPath::SDMCDir) +
                          "Nintendo "
                          "3DS/00000000000000000000000000000000/00000000000000000000000000000000/"
-                         "extdata/00000000/{}");
+                         "extdata/00000000/");
     ProcessDirectory(0x00048000, ContentType::NandExtdata,
                      fmt::format("{}extdata/00048000/", nand_config.data_path),
                      FileUtil::GetUserPath(FileUtil::UserPath::NANDDir) +
-                         "data/00000000000000000000000000000000/extdata/00048000/{}");
+                         "data/00000000000000000000000000000000/extdata/00048000/");
 }
 
-void SDMCImporter::ListSysdata(std::vector<ContentSpecifier>& out) const {
+void SDMCImporter::ListSysdata(ContentBatcher& out) const {
     const auto CheckContent = [&out](u64 id, const std::string& var_path,
                                      const std::string& citra_path,
                                      const std::string& display_name) {
@@ -1152,10 +1611,8 @@ static std::string GetID0(const std::string& movable_sed_path) {
 }
 
 // Gets SDMC path (Nintendo 3DS/<ID0>/<ID1>) from ID0 folder. Basically just takes the first
-// folder contained within, that matches the ID regex.
+// folder contained within, that looks like an ID.
 static std::string GetSDMCPath(const std::string& id0_folder) {
-    static const std::regex IdRegex{"[0-9a-f]{32}"};
-
     std::string result;
     FileUtil::ForeachDirectoryEntry(
         nullptr, id0_folder,
@@ -1164,7 +1621,7 @@ static std::string GetSDMCPath(const std::string& id0_folder) {
             if (!FileUtil::IsDirectory(directory + virtual_name + "/")) {
                 return true;
             }
-            if (!std::regex_match(virtual_name, IdRegex)) {
+            if (!IsHexName(virtual_name, 32)) {
                 return true;
             }
             result = virtual_name;
@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <functional>
+#include <future>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -13,11 +16,20 @@
 #include "common/progress_callback.h"
 #include "core/file_decryptor.h"
 #include "core/file_sys/cia_common.h"
+#include "core/file_sys/data/data_container.h"
 #include "core/file_sys/smdh.h"
+#include "core/icon_atlas.h"
+
+namespace Common {
+class Arena;
+}
 
 namespace Core {
 
 class CIABuilder;
+class CIAReader;
+class ContentBatcher;
+struct ContentFilter;
 class SDMCDecryptor;
 class TicketDB;
 class TitleDB;
@@ -52,7 +64,7 @@ struct ContentSpecifier {
     u64 maximum_size; ///< The maximum size of the content. May be slightly bigger than real size.
     std::string name; ///< Optional. The content's preferred display name.
     u64 extdata_id;   ///< Extdata ID for Applications.
-    std::vector<u16> icon; ///< Optional. The content's icon.
+    u32 icon_id;      ///< Optional. ID of the content's icon in the importer's IconAtlas.
 };
 
 /**
@@ -107,6 +119,18 @@ constexpr bool IsConfigComplete(const Config& config) {
            !config.nands[0].data_path.empty();
 }
 
+/**
+ * Outputs to produce for a title with SDMCImporter::ExportTitle.
+ * Destination paths ending with '/' are directories, in which filenames are generated.
+ */
+struct TitleOutputs {
+    bool import = false;  ///< Whether to import the title into Citra.
+    bool verify = false;  ///< Whether to check the contents (and the CXI/CIA) against their hashes.
+    std::string cia_path; ///< Optional. Destination of the CIA.
+    CIABuildType cia_type = CIABuildType::Standard;
+    std::string cxi_path; ///< Optional. Destination of the CXI. Applications only.
+};
+
 class SDMCFile;
 class NCCHContainer;
 
@@ -133,6 +157,38 @@ public:
      */
     void AbortImporting();
 
+    /**
+     * Sets whether titles are checked against their TMD hashes while being imported.
+     * When set, each content is hashed as it is written, and importing fails as soon as a
+     * content does not match.
+     */
+    void SetVerifyTitles(bool verify) {
+        verify_titles = verify;
+    }
+
+    bool GetVerifyTitles() const {
+        return verify_titles;
+    }
+
+    /**
+     * Sets whether savegames and extdata are checked against their IVFC hash trees while being
+     * imported. Corrupt blocks do not fail the import, as they may be in free space; they are
+     * reported through TakeCorruptData instead.
+     */
+    void SetVerifyData(bool verify) {
+        verify_data = verify;
+    }
+
+    bool GetVerifyData() const {
+        return verify_data;
+    }
+
+    /**
+     * Gets the files with corrupt blocks found in the savegames and extdata imported since the
+     * last call, and clears the list.
+     */
+    std::vector<CorruptFile> TakeCorruptData();
+
     /**
      * Dumps a content to CXI.
      * Blocks, but can be aborted on another thread.
@@ -155,11 +211,28 @@ public:
                   std::string destination, const Common::ProgressCallback& callback,
                   bool auto_filename = false);
 
+    /**
+     * Builds a Legit or PirateLegit CIA from a content, writing it strictly sequentially, so that
+     * the destination may be a pipe or another stream rather than a seekable file.
+     * Blocks, but can be aborted on another thread with AbortBuildCIA.
+     * @return true on success, false otherwise
+     */
+    bool StreamCIA(CIABuildType build_type, const ContentSpecifier& specifier,
+                   std::shared_ptr<FileUtil::IOFile> destination,
+                   const Common::ProgressCallback& callback);
+
     /**
      * Checks if a content can be built as a legit CIA.
      */
     bool CanBuildLegitCIA(const ContentSpecifier& specifier) const;
 
+    /**
+     * Checks if each of a list of contents can be built as a legit CIA.
+     * The checks are done in parallel.
+     * @return a bitmap, in the same order as specifiers
+     */
+    std::vector<bool> CanBuildLegitCIA(const std::vector<ContentSpecifier>& specifiers) const;
+
     /**
      * Aborts current CIA building
      */
@@ -172,11 +245,41 @@ public:
         const ContentSpecifier& specifier,
         const Common::ProgressCallback& callback = [](u64, u64) {});
 
+    /**
+     * Produces several outputs of a title at once (importing, building a CIA, dumping the CXI
+     * and checking the contents), reading and decrypting each content only once.
+     * Blocks, but can be aborted on another thread.
+     * @return true on success, false otherwise. When failed, the outputs are removed.
+     */
+    bool ExportTitle(
+        const ContentSpecifier& specifier, const TitleOutputs& outputs,
+        const Common::ProgressCallback& callback = [](u64, u64) {});
+
+    /**
+     * Aborts current title exporting.
+     */
+    void AbortExportTitle();
+
     /**
      * Gets a list of dumpable content specifiers.
      */
     std::vector<ContentSpecifier> ListContent() const;
 
+    /**
+     * Gets a list of dumpable content specifiers, delivering them in small batches as soon as
+     * they are found so that the list can be displayed while it is still being populated.
+     * The callback is invoked on the calling thread.
+     * @param cancelled Checked between titles and archives. Listing stops early once it is set.
+     */
+    void ListContent(const std::function<void(std::vector<ContentSpecifier>)>& callback,
+                     const std::atomic_bool& cancelled) const;
+
+    /**
+     * Gets the dumpable contents that match a filter, e.g. for selecting contents to import
+     * without going through the GUI.
+     */
+    std::vector<ContentSpecifier> FilterContent(const ContentFilter& filter) const;
+
     /**
      * Returns whether the importer is in good state.
      */
@@ -189,11 +292,31 @@ public:
     std::shared_ptr<FileUtil::IOFile> OpenContent(const ContentSpecifier& specifier,
                                                   u32 content_id) const;
 
+    /**
+     * Reads ahead the TMD and the beginning of the contents of a title into the page cache, so
+     * that a following operation on it does not start with cold reads. Other content types are
+     * small and not prefetched. Thread-safe; meant to be run on a background thread.
+     * @param max_size Maximum number of bytes to read from the contents.
+     * @param cancelled Stops prefetching when set.
+     */
+    void PrefetchContent(const ContentSpecifier& specifier, u64 max_size,
+                         const std::atomic_bool& cancelled) const;
+
+    /**
+     * Blocks until the DBs that are loaded in the background (certs.db, ticket.db) are ready.
+     * This is done automatically by functions that use them. Only call this before
+     * using the DBs directly (e.g. validating signatures).
+     * @return true if all of them are loaded successfully, false otherwise
+     */
+    bool WaitForBackgroundDBs() const;
+
     std::shared_ptr<TicketDB>& GetTicketDB() {
+        WaitForBackgroundDBs();
         return ticket_db;
     }
 
     const std::shared_ptr<TicketDB>& GetTicketDB() const {
+        WaitForBackgroundDBs();
         return ticket_db;
     }
 
@@ -201,6 +324,11 @@ public:
         return system_language;
     }
 
+    /// Gets the atlas holding the icons referenced by the listed ContentSpecifiers.
+    const IconAtlas& GetIconAtlas() const {
+        return icon_atlas;
+    }
+
 private:
     bool Init();
     void LoadSystemLanguage();
@@ -209,20 +337,27 @@ private:
     bool ImportContentImpl(
         const ContentSpecifier& specifier,
         const Common::ProgressCallback& callback = [](u64, u64) {});
-    bool ImportTitle(const ContentSpecifier& specifier, const Common::ProgressCallback& callback);
+    // When skip_contents is set, only the TMDs are imported (for ExportTitle).
+    bool ImportTitle(const ContentSpecifier& specifier, const Common::ProgressCallback& callback,
+                     bool skip_contents = false);
     bool ImportNandTitle(const ContentSpecifier& specifier,
-                         const Common::ProgressCallback& callback);
+                         const Common::ProgressCallback& callback, bool skip_contents = false);
     bool ImportSavegame(u64 id, const Common::ProgressCallback& callback);
     bool ImportNandSavegame(u64 id, const Common::ProgressCallback& callback);
     bool ImportExtdata(u64 id, const Common::ProgressCallback& callback);
     bool ImportNandExtdata(u64 id, const Common::ProgressCallback& callback);
     bool ImportSysdata(u64 id, const Common::ProgressCallback& callback);
 
-    void ListTitle(std::vector<ContentSpecifier>& out) const;
-    void ListNandTitle(std::vector<ContentSpecifier>& out) const;
-    void ListNandSavegame(std::vector<ContentSpecifier>& out) const;
-    void ListExtdata(std::vector<ContentSpecifier>& out) const;
-    void ListSysdata(std::vector<ContentSpecifier>& out) const;
+    // found_tmd_path is used when the title is not in title.db. If empty, the TMD is searched for.
+    bool LoadTMD(ContentType type, u64 id, const std::string& found_tmd_path,
+                 TitleMetadata& out) const;
+
+    // The parse objects of each title are allocated from `arena`, which is reset for every title
+    void ListTitle(ContentBatcher& out, Common::Arena& arena) const;
+    void ListNandTitle(ContentBatcher& out, Common::Arena& arena) const;
+    void ListNandSavegame(ContentBatcher& out) const;
+    void ListExtdata(ContentBatcher& out) const;
+    void ListSysdata(ContentBatcher& out) const;
 
     void DeleteContent(const ContentSpecifier& specifier) const;
     void DeleteTitle(u64 id) const;
@@ -234,21 +369,38 @@ private:
     void DeleteSysdata(u64 id) const;
 
     bool is_good{};
+    bool verify_titles{};
+    bool verify_data{};
+    std::vector<CorruptFile> corrupt_data;
     Config config;
     Config::NandConfig nand_config; // Main NAND config
     // System language, determined from config savegame. Used to return the title's names.
     SMDH::TitleLanguage system_language{SMDH::TitleLanguage::English};
 
+    // Icons of listed contents. Only ever grows, so that IDs stay valid across listings.
+    mutable IconAtlas icon_atlas;
+
     std::unique_ptr<SDMCDecryptor> sdmc_decryptor;
     FileDecryptor file_decryptor;
 
     // Used for CIA building
     std::unique_ptr<CIABuilder> cia_builder;
     std::shared_ptr<TicketDB> ticket_db;
+    std::shared_future<bool> certs_db_loaded;
+    std::shared_future<bool> ticket_db_loaded;
 
     // The NCCH used to dump CXIs.
     std::unique_ptr<NCCHContainer> dump_cxi_ncch;
 
+    // Used to verify built CIAs.
+    std::unique_ptr<CIAReader> verify_cia_reader;
+
+    // Guards dump_cxi_ncch and verify_cia_reader during ExportTitle against AbortExportTitle.
+    std::mutex export_mutex;
+    // Set by aborting and kept until the next ExportTitle, so that an abort between the contents
+    // of a title is not lost.
+    bool export_aborted = false;
+
     std::unique_ptr<TitleDB> sdmc_title_db{};
     std::unique_ptr<TitleDB> nand_title_db{};
 };
@@ -0,0 +1,158 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <fmt/format.h>
+#include "common/file_util.h"
+#include "core/layout_index.h"
+
+namespace Core {
+
+// Same as the default of FileUtil::GetDirectoryTreeSize
+constexpr unsigned int MaxRecursion = 256;
+
+bool IsHexName(std::string_view name, std::size_t length) {
+    return name.size() == length && std::all_of(name.begin(), name.end(), [](char c) {
+               return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+           });
+}
+
+static u64 GetTreeSize(const FileUtil::FSTEntry& entry) {
+    if (!entry.isDirectory) {
+        return entry.size;
+    }
+
+    u64 total_size = 0;
+    for (const auto& child : entry.children) {
+        total_size += GetTreeSize(child);
+    }
+    return total_size;
+}
+
+static const FileUtil::FSTEntry* FindChild(const FileUtil::FSTEntry& parent,
+                                           std::string_view name, bool is_directory) {
+    const auto iter = std::find_if(parent.children.begin(), parent.children.end(),
+                                   [name, is_directory](const FileUtil::FSTEntry& child) {
+                                       return child.isDirectory == is_directory &&
+                                              child.virtualName == name;
+                                   });
+    return iter == parent.children.end() ? nullptr : &*iter;
+}
+
+/// Returns the file name of the TMD with the smallest content ID, or empty if there is none.
+static std::string FindTMDName(const FileUtil::FSTEntry& content) {
+    std::string title_metadata;
+    for (const auto& child : content.children) {
+        const auto& name = child.virtualName;
+        if (child.isDirectory || name.size() != 12 || name.compare(8, 4, ".tmd") != 0 ||
+            !IsHexName(std::string_view{name}.substr(0, 8), 8)) {
+            continue;
+        }
+        title_metadata = title_metadata.empty() ? name : std::min(title_metadata, name);
+    }
+    return title_metadata;
+}
+
+std::string FindTMD(const std::string& content_path) {
+    FileUtil::FSTEntry content;
+    FileUtil::ScanDirectoryTree(content_path, content, 0);
+
+    const auto title_metadata = FindTMDName(content);
+    if (title_metadata.empty()) { // TMD not found
+        return {};
+    }
+    return content_path + title_metadata;
+}
+
+void LayoutIndex::ScanTitles(const std::string& path, const std::vector<u32>& high_ids,
+                             bool measure) {
+    for (const u32 high_id : high_ids) {
+        const auto high_path = fmt::format("{}{:08x}/", path, high_id);
+
+        // Without measuring, only <low ID>/{content,data} need to be seen.
+        FileUtil::FSTEntry root;
+        FileUtil::ScanDirectoryTree(high_path, root, measure ? MaxRecursion : 1);
+
+        for (const auto& low : root.children) {
+            if (!low.isDirectory || !IsHexName(low.virtualName, 8)) {
+                continue;
+            }
+
+            Title title;
+            title.id =
+                (static_cast<u64>(high_id) << 32) | std::stoull(low.virtualName, nullptr, 16);
+            if (const auto* content = FindChild(low, "content", true)) {
+                title.has_content = true;
+                if (measure) {
+                    title.content_size = GetTreeSize(*content);
+                    if (const auto tmd = FindTMDName(*content); !tmd.empty()) {
+                        title.tmd_path = high_path + low.virtualName + "/content/" + tmd;
+                    }
+                }
+            }
+            if (const auto* data = FindChild(low, "data", true)) {
+                title.has_data = true;
+                if (measure) {
+                    title.data_size = GetTreeSize(*data);
+                }
+            }
+            titles.insert_or_assign(title.id, std::move(title));
+        }
+    }
+}
+
+void LayoutIndex::ScanArchives(const std::string& path, u32 high_id, const std::string& file,
+                               bool measure) {
+    unsigned int recursion = 0; // Only the archive directories need to be seen by default
+    if (!file.empty()) {
+        recursion = 1;
+    } else if (measure) {
+        recursion = MaxRecursion;
+    }
+
+    FileUtil::FSTEntry root;
+    FileUtil::ScanDirectoryTree(path, root, recursion);
+
+    for (const auto& directory : root.children) {
+        if (!directory.isDirectory || !IsHexName(directory.virtualName, 8)) {
+            continue;
+        }
+
+        Archive archive;
+        archive.id = (static_cast<u64>(high_id) << 32) |
+                     std::stoull(directory.virtualName, nullptr, 16);
+        archive.path = path + directory.virtualName + "/";
+        if (!file.empty()) {
+            const auto* entry = FindChild(directory, file, false);
+            if (!entry) {
+                continue;
+            }
+            archive.path += file;
+            archive.size = entry->size;
+        } else if (measure) {
+            archive.size = GetTreeSize(directory);
+        }
+        archives.insert_or_assign(archive.id, std::move(archive));
+    }
+}
+
+const LayoutIndex::Title* LayoutIndex::FindTitle(u64 id) const {
+    const auto iter = titles.find(id);
+    return iter == titles.end() ? nullptr : &iter->second;
+}
+
+const LayoutIndex::Archive* LayoutIndex::FindArchive(u64 id) const {
+    const auto iter = archives.find(id);
+    return iter == archives.end() ? nullptr : &iter->second;
+}
+
+const std::map<u64, LayoutIndex::Title>& LayoutIndex::GetTitles() const {
+    return titles;
+}
+
+const std::map<u64, LayoutIndex::Archive>& LayoutIndex::GetArchives() const {
+    return archives;
+}
+
+} // namespace Core
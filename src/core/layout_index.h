@@ -0,0 +1,79 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common/common_types.h"
+
+namespace Core {
+
+/// Returns whether a file name consists of exactly `length` lowercase hex digits, like IDs do.
+bool IsHexName(std::string_view name, std::size_t length);
+
+/**
+ * Finds the TMD in a title's content directory. When there are multiple, the one with the
+ * smallest content ID is chosen, as the others are pending installation.
+ * @return Full path to the TMD, or empty if not found
+ */
+std::string FindTMD(const std::string& content_path);
+
+/**
+ * Typed in-memory index of the titles or archives in a directory tree (of the SD card, the
+ * NAND or Citra's user directory), built by walking the tree once. Replaces probing the file
+ * system path by path when listing contents.
+ */
+class LayoutIndex {
+public:
+    struct Title {
+        u64 id{};
+        bool has_content = false;
+        u64 content_size = 0; ///< Total size of content/. Only when measured
+        std::string tmd_path; ///< Full path of the TMD in content/. Only when measured
+        bool has_data = false;
+        u64 data_size = 0; ///< Total size of data/. Only when measured
+    };
+
+    struct Archive {
+        u64 id{};
+        std::string path; ///< Full path to the archive directory or file
+        u64 size = 0;     ///< Total size of the archive. Only when measured
+    };
+
+    /**
+     * Scans title directories, i.e. <path><high ID>/<low ID>/{content,data}/.
+     * @param measure Whether to compute sizes and find TMDs, or only record what exists.
+     */
+    void ScanTitles(const std::string& path, const std::vector<u32>& high_ids, bool measure);
+
+    /**
+     * Scans archive directories, i.e. <path><low ID>/.
+     * @param file When not empty, only directories containing this file are indexed, and the
+     *             file itself is the archive.
+     * @param measure Whether to compute sizes, or only record what exists.
+     */
+    void ScanArchives(const std::string& path, u32 high_id, const std::string& file,
+                      bool measure);
+
+    /// Gets a title, or nullptr if it does not exist.
+    const Title* FindTitle(u64 id) const;
+
+    /// Gets an archive, or nullptr if it does not exist.
+    const Archive* FindArchive(u64 id) const;
+
+    /// Titles, sorted by ID.
+    const std::map<u64, Title>& GetTitles() const;
+
+    /// Archives, sorted by ID.
+    const std::map<u64, Archive>& GetArchives() const;
+
+private:
+    std::map<u64, Title> titles;
+    std::map<u64, Archive> archives;
+};
+
+} // namespace Core
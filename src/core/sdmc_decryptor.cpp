@@ -70,24 +70,33 @@ void SDMCDecryptor::Abort() {
     file_decryptor.Abort();
 }
 
-std::vector<u8> SDMCDecryptor::DecryptFile(const std::string& source) const {
+template <typename Container>
+Container SDMCDecryptor::DecryptFile(const std::string& source) const {
     auto ctr = GetFileCTR(source);
     auto key = Key::GetNormalKey(Key::SDKey);
     CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption aes;
     aes.SetKeyWithIV(key.data(), key.size(), ctr.data());
 
     FileUtil::IOFile file(root_folder + source, "rb");
-    std::vector<u8> encrypted_data = file.GetData();
-    if (encrypted_data.empty()) {
+    auto data = file.GetData<Container>();
+    if (data.empty()) {
         LOG_ERROR(Core, "Failed to read from {}", root_folder + source);
         return {};
     }
 
-    std::vector<u8> data(file.GetSize());
-    aes.ProcessData(data.data(), encrypted_data.data(), encrypted_data.size());
+    // Decrypt in place, so that only one copy of the file is held in memory
+    aes.ProcessData(data.data(), data.data(), data.size());
     return data;
 }
 
+template std::vector<u8> SDMCDecryptor::DecryptFile(const std::string&) const;
+template Common::PooledBuffer SDMCDecryptor::DecryptFile(const std::string&) const;
+
+u64 SDMCDecryptor::GetFileSize(const std::string& source) const {
+    const auto path = root_folder + source;
+    return FileUtil::Exists(path) ? FileUtil::GetSize(path) : 0;
+}
+
 struct SDMCFile::Impl {
     CryptoPP::CTR_Mode<CryptoPP::AES>::Decryption aes;
     std::array<u8, 16> original_ctr;
@@ -6,6 +6,7 @@
 
 #include <string>
 #include <vector>
+#include "common/buffer_pool.h"
 #include "common/common_types.h"
 #include "common/file_util.h"
 #include "common/logging/log.h"
@@ -38,10 +39,19 @@ public:
     void Abort();
 
     /**
-     * Decrypts a file and reads it into a vector.
+     * Decrypts a file and reads it into a container.
+     * @tparam Container std::vector<u8>, or Common::PooledBuffer for pooled memory
      * @param source Path to the file relative to the root folder, starting with "/".
      */
-    std::vector<u8> DecryptFile(const std::string& source) const;
+    template <typename Container = std::vector<u8>>
+    Container DecryptFile(const std::string& source) const;
+
+    /**
+     * Gets the size of a file, e.g. to reserve memory before DecryptFile.
+     * @param source Path to the file relative to the root folder, starting with "/".
+     * @return Size of the file, or 0 if it does not exist
+     */
+    u64 GetFileSize(const std::string& source) const;
 
 private:
     std::string root_folder;
@@ -0,0 +1,148 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "core/tee_file.h"
+
+namespace Core {
+
+TeeFile::TeeFile(std::vector<std::shared_ptr<FileUtil::IOFile>> sinks_)
+    : sinks(std::move(sinks_)) {}
+
+TeeFile::~TeeFile() = default;
+
+std::size_t TeeFile::Write(const char* data, std::size_t length) {
+    std::size_t length_written = length;
+    for (auto& sink : sinks) {
+        length_written = std::min(length_written, sink->Write(data, length));
+    }
+    return length_written;
+}
+
+bool TeeFile::Preallocate(u64 size) {
+    bool ret = true;
+    for (auto& sink : sinks) {
+        ret = sink->Preallocate(size) && ret;
+    }
+    return ret;
+}
+
+void TeeFile::Advise(s64 offset, u64 length, CacheAdvice advice) {
+    for (auto& sink : sinks) {
+        sink->Advise(offset, length, advice);
+    }
+}
+
+void TeeFile::Writeback(s64 offset, u64 length, bool wait) {
+    for (auto& sink : sinks) {
+        sink->Writeback(offset, length, wait);
+    }
+}
+
+ForwardingFile::ForwardingFile(std::shared_ptr<FileUtil::IOFile> source_,
+                               std::shared_ptr<FileUtil::IOFile> sink_)
+    : source(std::move(source_)), sink(std::move(sink_)) {
+
+    if (source->IsOpen()) {
+        source->Seek(0, SEEK_SET);
+    }
+}
+
+ForwardingFile::~ForwardingFile() = default;
+
+std::size_t ForwardingFile::Read(char* data, std::size_t length) {
+    if (position > forwarded && !ForwardUntil(position)) {
+        return 0;
+    }
+
+    const std::size_t length_read = source->Read(data, length);
+    if (length_read > length) { // Error
+        return length_read;
+    }
+
+    const u64 end = position + length_read;
+    if (end > forwarded) {
+        const std::size_t to_forward = static_cast<std::size_t>(end - forwarded);
+        if (sink->Write(data + (forwarded - position), to_forward) != to_forward) {
+            sink_good = false;
+        }
+        forwarded = end;
+    }
+    position = end;
+    return length_read;
+}
+
+std::size_t ForwardingFile::Write([[maybe_unused]] const char* data,
+                                  [[maybe_unused]] std::size_t length) {
+    UNREACHABLE_MSG("Cannot write to a ForwardingFile");
+}
+
+bool ForwardingFile::Seek(s64 off, int origin) {
+    if (!source->Seek(off, origin)) {
+        return false;
+    }
+    position = source->Tell();
+    return true;
+}
+
+bool ForwardingFile::IsOpen() const {
+    return source->IsOpen();
+}
+
+u64 ForwardingFile::Tell() const {
+    return position;
+}
+
+u64 ForwardingFile::GetSize() const {
+    return source->GetSize();
+}
+
+void ForwardingFile::Advise(s64 offset, u64 length, CacheAdvice advice) {
+    // Data skipped over is still to be read for forwarding, so it must not be dropped
+    if (advice == CacheAdvice::DontNeed &&
+        static_cast<s64>(position) + offset + static_cast<s64>(length) >
+            static_cast<s64>(forwarded)) {
+        return;
+    }
+    const s64 source_offset = static_cast<s64>(position) - static_cast<s64>(source->Tell());
+    source->Advise(source_offset + offset, length, advice);
+}
+
+bool ForwardingFile::Finish() {
+    const u64 size = source->GetSize();
+    if (forwarded < size) {
+        if (!ForwardUntil(size)) {
+            return false;
+        }
+        source->Seek(position, SEEK_SET);
+    }
+    return sink_good;
+}
+
+bool ForwardingFile::ForwardUntil(u64 end) {
+    static constexpr std::size_t BufferSize = 16 * 1024;
+
+    if (!source->Seek(forwarded, SEEK_SET)) {
+        return false;
+    }
+
+    std::vector<char> buffer(std::min<u64>(BufferSize, end - forwarded));
+    while (forwarded < end) {
+        const auto to_read =
+            static_cast<std::size_t>(std::min<u64>(buffer.size(), end - forwarded));
+        if (source->Read(buffer.data(), to_read) != to_read) {
+            LOG_ERROR(Core, "Could not read source at {:#x}", forwarded);
+            return false;
+        }
+        if (sink->Write(buffer.data(), to_read) != to_read) {
+            sink_good = false;
+        }
+        forwarded += to_read;
+    }
+    return sink_good;
+}
+
+} // namespace Core
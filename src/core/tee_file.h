@@ -0,0 +1,75 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "common/common_types.h"
+#include "common/file_util.h"
+
+namespace Core {
+
+/**
+ * Write-only file that duplicates everything written to it into several sink files, so that one
+ * stream of data can produce several outputs.
+ */
+class TeeFile : public FileUtil::IOFile {
+public:
+    explicit TeeFile(std::vector<std::shared_ptr<FileUtil::IOFile>> sinks);
+    ~TeeFile() override;
+
+    /// Writes to every sink. Returns the smallest length written.
+    std::size_t Write(const char* data, std::size_t length) override;
+
+    /// Preallocates every sink. Returns whether all of them succeeded.
+    bool Preallocate(u64 size) override;
+
+    void Advise(s64 offset, u64 length, CacheAdvice advice) override;
+    void Writeback(s64 offset, u64 length, bool wait) override;
+
+private:
+    std::vector<std::shared_ptr<FileUtil::IOFile>> sinks;
+};
+
+/**
+ * Read-only file wrapping another file, which additionally forwards the source's data to a sink,
+ * in order and exactly once, as it is read.
+ * The reader may seek freely: data skipped over by forward seeks is read and forwarded on the
+ * next read, while data that has already been forwarded is not forwarded again. This allows
+ * readers that mostly proceed forwards (like NCCH decryption) to also produce an exact copy of
+ * the source in the same pass.
+ */
+class ForwardingFile : public FileUtil::IOFile {
+public:
+    explicit ForwardingFile(std::shared_ptr<FileUtil::IOFile> source,
+                            std::shared_ptr<FileUtil::IOFile> sink);
+    ~ForwardingFile() override;
+
+    std::size_t Read(char* data, std::size_t length) override;
+    std::size_t Write(const char* data, std::size_t length) override;
+    bool Seek(s64 off, int origin) override;
+    bool IsOpen() const override;
+    u64 Tell() const override;
+    u64 GetSize() const override;
+    void Advise(s64 offset, u64 length, CacheAdvice advice) override;
+
+    /**
+     * Reads and forwards the rest of the source which has not been forwarded yet.
+     * @return true if the whole source has been forwarded successfully, false otherwise
+     */
+    bool Finish();
+
+private:
+    /// Reads and forwards data from the current forwarded position until `end`.
+    bool ForwardUntil(u64 end);
+
+    std::shared_ptr<FileUtil::IOFile> source;
+    std::shared_ptr<FileUtil::IOFile> sink;
+    u64 position = 0;  ///< Current read position
+    u64 forwarded = 0; ///< Size of the source data forwarded so far
+    bool sink_good = true;
+};
+
+} // namespace Core
@@ -0,0 +1,673 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <QImage>
+#include <QPixmap>
+#include "common/assert.h"
+#include "frontend/content_list_model.h"
+#include "frontend/helpers/frontend_common.h"
+
+// clang-format off
+// group, singular name, plural name, icon name
+constexpr std::array<std::tuple<DisplayGroup, const char*, const char*, const char*>, 8>
+    DisplayGroupMap{{
+        {DisplayGroup::Application, QT_TR_NOOP("Application"), QT_TR_NOOP("Applications"), "app"},
+        {DisplayGroup::Update, QT_TR_NOOP("Update"), QT_TR_NOOP("Updates"), "update"},
+        {DisplayGroup::DLC, QT_TR_NOOP("DLC"), QT_TR_NOOP("DLCs"), "dlc"},
+        {DisplayGroup::Savegame, QT_TR_NOOP("Save Data"), QT_TR_NOOP("Save Data"), "save_data"},
+        {DisplayGroup::Extdata, QT_TR_NOOP("Extra Data"), QT_TR_NOOP("Extra Data"), "save_data"},
+        {DisplayGroup::Sysdata, QT_TR_NOOP("System Data"), QT_TR_NOOP("System Data"), "system_data"},
+        {DisplayGroup::SystemTitle, QT_TR_NOOP("System Title"), QT_TR_NOOP("System Titles"), "hos"},
+        {DisplayGroup::SystemApplet, QT_TR_NOOP("System Applet"), QT_TR_NOOP("System Applets"), "hos"},
+    }};
+// clang-format on
+
+// Content types that themselves form a 'Title' like entity.
+constexpr std::array<DisplayGroup, 3> SpecialDisplayGroupList{{
+    DisplayGroup::Sysdata,
+    DisplayGroup::SystemTitle,
+    DisplayGroup::SystemApplet,
+}};
+
+static bool IsSpecialDisplayGroup(DisplayGroup group) {
+    return std::find(SpecialDisplayGroupList.begin(), SpecialDisplayGroupList.end(), group) !=
+           SpecialDisplayGroupList.end();
+}
+
+static bool IsApplication(const Core::ContentSpecifier& specifier) {
+    return specifier.type == Core::ContentType::Title && (specifier.id >> 32) == 0x00040000;
+}
+
+DisplayGroup GetDisplayGroup(const Core::ContentSpecifier& specifier) {
+    if (specifier.type == Core::ContentType::Title) {
+        switch (specifier.id >> 32) {
+        case 0x00040000:
+            return DisplayGroup::Application;
+        case 0x0004000e:
+            return DisplayGroup::Update;
+        case 0x0004008c:
+            return DisplayGroup::DLC;
+        default:
+            UNREACHABLE();
+        }
+    }
+    if (specifier.type == Core::ContentType::Savegame) {
+        return DisplayGroup::Savegame;
+    }
+    if (specifier.type == Core::ContentType::Extdata) {
+        return DisplayGroup::Extdata;
+    }
+    if (specifier.type == Core::ContentType::NandSavegame ||
+        specifier.type == Core::ContentType::NandExtdata ||
+        specifier.type == Core::ContentType::Sysdata) { // These are grouped together
+
+        return DisplayGroup::Sysdata;
+    }
+    if (specifier.type == Core::ContentType::NandTitle) {
+        return (specifier.id >> 32) == 0x00040030 ? DisplayGroup::SystemApplet
+                                                  : DisplayGroup::SystemTitle;
+    }
+    UNREACHABLE();
+}
+
+QString GetContentName(const Core::ContentSpecifier& specifier) {
+    if (specifier.type == Core::ContentType::NandSavegame) {
+        return QObject::tr("System Save 0x%1", "ImportDialog")
+            .arg(specifier.id, 16, 16, QLatin1Char('0'));
+    }
+    if (specifier.type == Core::ContentType::NandExtdata) {
+        return QObject::tr("System Extra 0x%1", "ImportDialog")
+            .arg(specifier.id, 16, 16, QLatin1Char('0'));
+    }
+    return specifier.name.empty()
+               ? QStringLiteral("0x%1").arg(specifier.id, 16, 16, QLatin1Char('0'))
+               : QString::fromStdString(specifier.name);
+}
+
+QString GetDisplayGroupName(DisplayGroup group, bool plural) {
+    const auto& entry = DisplayGroupMap.at(static_cast<std::size_t>(group));
+    return QObject::tr(plural ? std::get<2>(entry) : std::get<1>(entry), "ImportDialog");
+}
+
+QString GetDisplayGroupName(const Core::ContentSpecifier& specifier, bool plural) {
+    return GetDisplayGroupName(GetDisplayGroup(specifier), plural);
+}
+
+// internalId of top level (group) indices. Content indices store the row of their group instead.
+constexpr quintptr TopLevelId = std::numeric_limits<quintptr>::max();
+
+ContentListModel::ContentListModel(QObject* parent, bool title_view_)
+    : QAbstractItemModel(parent), title_view(title_view_) {
+
+    CreateFixedGroups();
+}
+
+ContentListModel::~ContentListModel() = default;
+
+void ContentListModel::Clear(const Core::IconAtlas* icon_atlas_) {
+    beginResetModel();
+
+    icon_atlas = icon_atlas_;
+    contents.clear();
+    content_checked.clear();
+    content_rows.clear();
+    checked_size = 0;
+    groups.clear();
+    applications.clear();
+    extdata_titles.clear();
+    title_groups.clear();
+    atlas_icons.clear();
+    CreateFixedGroups();
+
+    endResetModel();
+}
+
+void ContentListModel::AppendContents(std::vector<Core::ContentSpecifier> new_contents) {
+    const std::size_t first = contents.size();
+    for (auto& content : new_contents) {
+        // Skip System Applets, but enable everything else by default.
+        const bool checked =
+            !content.already_exists && GetDisplayGroup(content) != DisplayGroup::SystemApplet;
+        if (checked) {
+            checked_size += content.maximum_size;
+        }
+        content_checked.push_back(checked);
+        content_rows.push_back(0);
+        contents.emplace_back(std::move(content));
+    }
+
+    // Register applications first so that their contents in the same batch are grouped with them
+    std::vector<std::size_t> new_applications;
+    for (std::size_t i = first; i < contents.size(); ++i) {
+        if (RegisterApplication(i)) {
+            new_applications.emplace_back(i);
+        }
+    }
+    if (title_view && !new_applications.empty()) {
+        const int row = static_cast<int>(groups.size());
+        beginInsertRows({}, row, row + static_cast<int>(new_applications.size()) - 1);
+        for (const std::size_t application : new_applications) {
+            AddTitleGroup(application);
+        }
+        endInsertRows();
+    }
+
+    std::map<std::size_t, std::vector<std::size_t>> additions; // group row -> contents
+    for (std::size_t i = first; i < contents.size(); ++i) {
+        additions[FindGroup(i)].emplace_back(i);
+    }
+    for (const auto& [group_row, content_indices] : additions) {
+        const auto parent = index(static_cast<int>(group_row), 0);
+        const int row = static_cast<int>(groups[group_row].children.size());
+        beginInsertRows(parent, row, row + static_cast<int>(content_indices.size()) - 1);
+        for (const std::size_t content_index : content_indices) {
+            AddToGroup(group_row, content_index);
+        }
+        endInsertRows();
+
+        // Totals and check state of the group have changed
+        emit dataChanged(parent, index(static_cast<int>(group_row), ColumnCount - 1));
+    }
+}
+
+void ContentListModel::SetTitleView(bool title_view_) {
+    if (title_view == title_view_) {
+        return;
+    }
+
+    beginResetModel();
+
+    title_view = title_view_;
+    groups.clear();
+    title_groups.clear();
+    CreateFixedGroups();
+    if (title_view) {
+        for (std::size_t i = 0; i < contents.size(); ++i) {
+            if (IsApplication(contents[i]) && applications.at(contents[i].id) == i) {
+                AddTitleGroup(i);
+            }
+        }
+    }
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        AddToGroup(FindGroup(i), i);
+    }
+
+    endResetModel();
+}
+
+const std::vector<Core::ContentSpecifier>& ContentListModel::GetContents() const {
+    return contents;
+}
+
+std::vector<Core::ContentSpecifier> ContentListModel::GetCheckedContents() const {
+    std::vector<Core::ContentSpecifier> out;
+    for (std::size_t i = 0; i < contents.size(); ++i) {
+        if (content_checked[i]) {
+            out.emplace_back(contents[i]);
+        }
+    }
+    return out;
+}
+
+u64 ContentListModel::GetCheckedSize() const {
+    return checked_size;
+}
+
+std::optional<std::size_t> ContentListModel::GetContentIndex(const QModelIndex& index) const {
+    if (!index.isValid() || index.internalId() == TopLevelId) {
+        return std::nullopt;
+    }
+    return groups[index.internalId()].children[index.row()];
+}
+
+std::vector<std::size_t> ContentListModel::GetGroupContents(const QModelIndex& index) const {
+    if (!index.isValid() || index.internalId() != TopLevelId) {
+        return {};
+    }
+    return groups[index.row()].children;
+}
+
+QModelIndex ContentListModel::index(int row, int column, const QModelIndex& parent) const {
+    if (!hasIndex(row, column, parent)) {
+        return {};
+    }
+    if (!parent.isValid()) {
+        return createIndex(row, column, TopLevelId);
+    }
+    return createIndex(row, column, static_cast<quintptr>(parent.row()));
+}
+
+QModelIndex ContentListModel::parent(const QModelIndex& child) const {
+    if (!child.isValid() || child.internalId() == TopLevelId) {
+        return {};
+    }
+    return createIndex(static_cast<int>(child.internalId()), 0, TopLevelId);
+}
+
+int ContentListModel::rowCount(const QModelIndex& parent) const {
+    if (!parent.isValid()) {
+        return static_cast<int>(groups.size());
+    }
+    if (parent.internalId() == TopLevelId && parent.column() == 0) {
+        return static_cast<int>(groups[parent.row()].children.size());
+    }
+    return 0;
+}
+
+int ContentListModel::columnCount([[maybe_unused]] const QModelIndex& parent) const {
+    return ColumnCount;
+}
+
+QVariant ContentListModel::data(const QModelIndex& index, int role) const {
+    if (!index.isValid()) {
+        return {};
+    }
+    return index.internalId() == TopLevelId ? GroupData(index, role) : ContentData(index, role);
+}
+
+bool ContentListModel::setData(const QModelIndex& index, const QVariant& value, int role) {
+    if (!index.isValid() || index.column() != NameColumn || role != Qt::CheckStateRole) {
+        return false;
+    }
+
+    const bool checked = static_cast<Qt::CheckState>(value.toInt()) == Qt::Checked;
+    if (index.internalId() == TopLevelId) { // Group, (un)check all its contents
+        std::vector<std::size_t> changed;
+        for (const std::size_t content_index : groups[index.row()].children) {
+            if (content_checked[content_index] != checked) {
+                changed.emplace_back(content_index);
+            }
+        }
+        SetContentsChecked(index.row(), changed, checked);
+    } else {
+        const std::size_t content_index = groups[index.internalId()].children[index.row()];
+        if (content_checked[content_index] != checked) {
+            SetContentsChecked(index.internalId(), {content_index}, checked);
+        }
+    }
+    return true;
+}
+
+Qt::ItemFlags ContentListModel::flags(const QModelIndex& index) const {
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+
+    Qt::ItemFlags flags = Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+    if (index.column() == NameColumn) {
+        flags |= Qt::ItemIsUserCheckable;
+    }
+    return flags;
+}
+
+QVariant ContentListModel::headerData(int section, Qt::Orientation orientation, int role) const {
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return {};
+    }
+
+    switch (section) {
+    case NameColumn:
+        return tr("Name");
+    case SizeColumn:
+        return tr("Size");
+    case ExistsColumn:
+        return tr("Exists");
+    default:
+        return {};
+    }
+}
+
+void ContentListModel::CreateFixedGroups() {
+    if (title_view) {
+        groups.push_back({Group::Type::Ungrouped});
+        for (const auto group : SpecialDisplayGroupList) {
+            groups.push_back({Group::Type::DisplayGroup, group});
+        }
+    } else {
+        for (const auto& [group, singular_name, plural_name, icon_name] : DisplayGroupMap) {
+            groups.push_back({Group::Type::DisplayGroup, group});
+        }
+    }
+}
+
+void ContentListModel::AddTitleGroup(std::size_t application) {
+    title_groups.emplace(contents[application].id, groups.size());
+    groups.push_back({Group::Type::Title, {}, application});
+}
+
+bool ContentListModel::RegisterApplication(std::size_t content_index) {
+    const auto& content = contents[content_index];
+    if (!IsApplication(content) || !applications.emplace(content.id, content_index).second) {
+        return false;
+    }
+    extdata_titles.emplace(content.extdata_id, content.id);
+    return true;
+}
+
+const Core::ContentSpecifier* ContentListModel::FindApplication(
+    const Core::ContentSpecifier& specifier) const {
+
+    u64 title_id{};
+    if (specifier.type == Core::ContentType::Savegame) {
+        title_id = specifier.id;
+    } else if (specifier.type == Core::ContentType::Extdata) {
+        const auto iter = extdata_titles.find(specifier.id);
+        if (iter == extdata_titles.end()) {
+            return nullptr;
+        }
+        title_id = iter->second;
+    } else {
+        return nullptr;
+    }
+
+    const auto iter = applications.find(title_id);
+    return iter == applications.end() ? nullptr : &contents[iter->second];
+}
+
+std::size_t ContentListModel::FindGroup(std::size_t content_index) const {
+    const auto& content = contents[content_index];
+    if (!title_view) {
+        return static_cast<std::size_t>(GetDisplayGroup(content));
+    }
+
+    std::size_t row = 0; // 0 for ungrouped (default)
+    switch (content.type) {
+    case Core::ContentType::Title:
+    case Core::ContentType::Savegame: {
+        // Fix the id
+        const auto iter = title_groups.find(content.id & 0xffffff00ffffffff);
+        if (iter != title_groups.end()) {
+            row = iter->second;
+        }
+        break;
+    }
+    case Core::ContentType::Extdata: {
+        if (const auto* application = FindApplication(content)) {
+            row = title_groups.at(application->id);
+        }
+        break;
+    }
+    default: {
+        const std::size_t idx = std::find(SpecialDisplayGroupList.begin(),
+                                          SpecialDisplayGroupList.end(), GetDisplayGroup(content)) -
+                                SpecialDisplayGroupList.begin();
+        ASSERT_MSG(idx < SpecialDisplayGroupList.size(), "Display Group not handled");
+        row = idx + 1;
+        break;
+    }
+    }
+    return row;
+}
+
+void ContentListModel::AddToGroup(std::size_t group_row, std::size_t content_index) {
+    const auto& content = contents[content_index];
+    auto& group = groups[group_row];
+
+    content_rows[content_index] = group.children.size();
+    group.children.emplace_back(content_index);
+    group.total_size += content.maximum_size;
+    if (content.already_exists) {
+        group.exists_count++;
+    }
+    if (content_checked[content_index]) {
+        group.checked_count++;
+    }
+}
+
+QVariant ContentListModel::GroupData(const QModelIndex& index, int role) const {
+    const auto& group = groups[index.row()];
+
+    if (role == Qt::DisplayRole || role == SortRole) {
+        // Only titles show totals
+        if (index.column() != NameColumn && group.type != Group::Type::Title) {
+            return {};
+        }
+
+        switch (index.column()) {
+        case NameColumn:
+            switch (group.type) {
+            case Group::Type::Ungrouped:
+                return tr("Ungrouped");
+            case Group::Type::DisplayGroup:
+                return GetDisplayGroupName(group.display_group);
+            case Group::Type::Title:
+                return GetContentName(contents[group.application]);
+            }
+            UNREACHABLE();
+        case SizeColumn:
+            if (role == SortRole) {
+                return static_cast<qulonglong>(group.total_size);
+            }
+            return ReadableByteSize(group.total_size);
+        case ExistsColumn:
+            if (group.exists_count == 0) {
+                return tr("No");
+            } else if (group.exists_count == group.children.size()) {
+                return tr("Yes");
+            } else {
+                return tr("Part");
+            }
+        default:
+            return {};
+        }
+    }
+
+    if (index.column() != NameColumn) {
+        return {};
+    }
+    if (role == Qt::DecorationRole) {
+        switch (group.type) {
+        case Group::Type::Ungrouped:
+            return ThemeIcon(QStringLiteral("unknown"));
+        case Group::Type::DisplayGroup:
+            return DisplayGroupIcon(group.display_group);
+        case Group::Type::Title:
+            return ContentIcon(contents[group.application]);
+        }
+    }
+    if (role == Qt::CheckStateRole) {
+        if (group.checked_count == 0) {
+            return Qt::Unchecked;
+        } else if (group.checked_count == group.children.size()) {
+            return Qt::Checked;
+        } else {
+            return Qt::PartiallyChecked;
+        }
+    }
+    return {};
+}
+
+QVariant ContentListModel::ContentData(const QModelIndex& index, int role) const {
+    const auto& group = groups[index.internalId()];
+    const std::size_t content_index = group.children[index.row()];
+    const auto& content = contents[content_index];
+
+    if (role == Qt::DisplayRole || role == SortRole) {
+        switch (index.column()) {
+        case NameColumn:
+            return ContentDisplayName(group, content_index);
+        case SizeColumn:
+            if (role == SortRole) {
+                return static_cast<qulonglong>(content.maximum_size);
+            }
+            return ReadableByteSize(content.maximum_size);
+        case ExistsColumn:
+            return content.already_exists ? tr("Yes") : tr("No");
+        default:
+            return {};
+        }
+    }
+
+    if (index.column() != NameColumn) {
+        return {};
+    }
+    if (role == Qt::DecorationRole) {
+        return ContentDisplayIcon(content_index);
+    }
+    if (role == Qt::CheckStateRole) {
+        return content_checked[content_index] ? Qt::Checked : Qt::Unchecked;
+    }
+    return {};
+}
+
+QString ContentListModel::ContentDisplayName(const Group& group, std::size_t content_index) const {
+    const auto& content = contents[content_index];
+    switch (group.type) {
+    case Group::Type::Ungrouped:
+        return QStringLiteral("%1 (%2)").arg(GetContentName(content),
+                                             GetDisplayGroupName(content, false));
+    case Group::Type::Title:
+        return GetDisplayGroupName(content, false);
+    case Group::Type::DisplayGroup:
+        // In Group View, save data are shown with the names of their applications
+        if (const auto* application = FindApplication(content); application && !title_view) {
+            return GetContentName(*application);
+        }
+        return GetContentName(content);
+    }
+    UNREACHABLE();
+}
+
+QIcon ContentListModel::ContentDisplayIcon(std::size_t content_index) const {
+    const auto& content = contents[content_index];
+    if (title_view) {
+        // Title groups already show the icon of the title, use category icons for the contents
+        const auto group = GetDisplayGroup(content);
+        return IsSpecialDisplayGroup(group) ? ContentIcon(content) : DisplayGroupIcon(group);
+    }
+
+    if (const auto* application = FindApplication(content)) {
+        return ContentIcon(*application);
+    }
+    return ContentIcon(content);
+}
+
+QIcon ContentListModel::ContentIcon(const Core::ContentSpecifier& specifier) const {
+    if (icon_atlas && specifier.icon_id != Core::IconAtlas::NoIcon) {
+        auto iter = atlas_icons.find(specifier.icon_id);
+        if (iter == atlas_icons.end()) { // Decode on first use
+            QIcon decoded;
+            if (const auto icon = icon_atlas->Get(specifier.icon_id); !icon.empty()) {
+                constexpr int Width = static_cast<int>(Core::IconAtlas::IconWidth);
+                const QImage image(reinterpret_cast<const uchar*>(icon.data()), Width, Width,
+                                   QImage::Format_RGB32);
+                decoded = QIcon(QPixmap::fromImage(image)); // Copies the pixels
+            }
+            iter = atlas_icons.emplace(specifier.icon_id, std::move(decoded)).first;
+        }
+        if (!iter->second.isNull()) {
+            return iter->second;
+        }
+    }
+
+    // Use a category icon to distinguish between different types of System Data
+    if (specifier.type == Core::ContentType::NandSavegame ||
+        specifier.type == Core::ContentType::NandExtdata) {
+        return DisplayGroupIcon(DisplayGroup::Savegame);
+    }
+    if (specifier.type == Core::ContentType::Sysdata) {
+        return DisplayGroupIcon(DisplayGroup::Sysdata);
+    }
+
+    // Use a special icon for NAND non-executable archives
+    if (specifier.type == Core::ContentType::NandTitle) {
+        const auto id_high = specifier.id >> 32;
+        if (id_high == 0x0004001b || id_high == 0x0004009b || id_high == 0x000400db) {
+            return ThemeIcon(QStringLiteral("system_archive"));
+        }
+    }
+
+    // Return a null icon otherwise
+    return ThemeIcon(QStringLiteral("unknown"));
+}
+
+QIcon ContentListModel::DisplayGroupIcon(DisplayGroup group) const {
+    return ThemeIcon(
+        QString::fromUtf8(std::get<3>(DisplayGroupMap.at(static_cast<std::size_t>(group)))));
+}
+
+QIcon ContentListModel::ThemeIcon(const QString& name) const {
+    auto iter = theme_icons.find(name);
+    if (iter == theme_icons.end()) {
+        iter = theme_icons.insert(name, QIcon::fromTheme(name));
+    }
+    return *iter;
+}
+
+void ContentListModel::SetContentsChecked(std::size_t group_row,
+                                          const std::vector<std::size_t>& content_indices,
+                                          bool checked) {
+    if (content_indices.empty()) {
+        return;
+    }
+
+    auto& group = groups[group_row];
+    std::size_t first_row = std::numeric_limits<std::size_t>::max();
+    std::size_t last_row = 0;
+    for (const std::size_t content_index : content_indices) {
+        content_checked[content_index] = checked;
+        if (checked) {
+            checked_size += contents[content_index].maximum_size;
+            group.checked_count++;
+        } else {
+            checked_size -= contents[content_index].maximum_size;
+            group.checked_count--;
+        }
+        first_row = std::min(first_row, content_rows[content_index]);
+        last_row = std::max(last_row, content_rows[content_index]);
+    }
+
+    const auto parent = index(static_cast<int>(group_row), NameColumn);
+    emit dataChanged(index(static_cast<int>(first_row), NameColumn, parent),
+                     index(static_cast<int>(last_row), NameColumn, parent), {Qt::CheckStateRole});
+    emit dataChanged(parent, parent, {Qt::CheckStateRole});
+    emit ContentsCheckStateChanged(content_indices, checked);
+}
+
+ContentListFilterModel::ContentListFilterModel(QObject* parent, ContentListModel* source_)
+    : QSortFilterProxyModel(parent), source(source_) {
+
+    setSourceModel(source);
+    setSortRole(ContentListModel::SortRole);
+}
+
+ContentListFilterModel::~ContentListFilterModel() = default;
+
+void ContentListFilterModel::SetVisibleContents(
+    const std::optional<std::vector<std::size_t>>& content_indices) {
+
+    is_filtered = content_indices.has_value();
+    visible.assign(is_filtered ? source->GetContents().size() : 0, false);
+    if (is_filtered) {
+        for (const std::size_t content_index : *content_indices) {
+            visible[content_index] = true;
+        }
+    }
+    invalidateFilter();
+}
+
+bool ContentListFilterModel::filterAcceptsRow(int source_row,
+                                              const QModelIndex& source_parent) const {
+    if (!is_filtered) {
+        return true;
+    }
+
+    const auto index = source->index(source_row, 0, source_parent);
+    if (const auto content_index = source->GetContentIndex(index)) {
+        return IsContentVisible(*content_index);
+    }
+    const auto children = source->GetGroupContents(index);
+    return std::any_of(children.begin(), children.end(),
+                       [this](std::size_t child) { return IsContentVisible(child); });
+}
+
+bool ContentListFilterModel::IsContentVisible(std::size_t content_index) const {
+    // Contents added after the filter has been applied are always shown
+    return content_index >= visible.size() || visible[content_index];
+}
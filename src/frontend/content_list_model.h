@@ -0,0 +1,175 @@
+// Copyright 2021 threeSD Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <optional>
+#include <unordered_map>
+#include <vector>
+#include <QAbstractItemModel>
+#include <QHash>
+#include <QIcon>
+#include <QSortFilterProxyModel>
+#include "core/importer.h"
+
+// Groups that are used in the frontend. This is organized in a slightly different way than Core.
+enum class DisplayGroup {
+    Application,
+    Update,
+    DLC,
+    Savegame,
+    Extdata,
+    Sysdata,
+    SystemTitle,
+    SystemApplet,
+};
+
+DisplayGroup GetDisplayGroup(const Core::ContentSpecifier& specifier);
+QString GetContentName(const Core::ContentSpecifier& specifier);
+QString GetDisplayGroupName(DisplayGroup group, bool plural = true);
+QString GetDisplayGroupName(const Core::ContentSpecifier& specifier, bool plural = true);
+
+/**
+ * Item model of the contents shown in the import dialog.
+ *
+ * Contents are grouped either by title (Title View) or by display group (Group View). The model
+ * only keeps the content list, check states and per-group totals; names and icons are produced
+ * on demand when the view asks for them, and icons from the IconAtlas are cached once decoded.
+ * Contents can be appended while they are still being listed.
+ */
+class ContentListModel final : public QAbstractItemModel {
+    Q_OBJECT
+
+public:
+    enum Column {
+        NameColumn,
+        SizeColumn,
+        ExistsColumn,
+        ColumnCount,
+    };
+
+    /// Role used for sorting. Sizes are sorted by value rather than by their readable text.
+    static constexpr int SortRole = Qt::UserRole;
+
+    explicit ContentListModel(QObject* parent, bool title_view);
+    ~ContentListModel() override;
+
+    /// Removes all contents. Icons of contents appended afterwards are looked up in icon_atlas.
+    void Clear(const Core::IconAtlas* icon_atlas);
+
+    void AppendContents(std::vector<Core::ContentSpecifier> new_contents);
+
+    /// Regroups the contents. Check states are kept.
+    void SetTitleView(bool title_view);
+
+    const std::vector<Core::ContentSpecifier>& GetContents() const;
+
+    /// Gets the checked contents, in the order they were listed.
+    std::vector<Core::ContentSpecifier> GetCheckedContents() const;
+
+    u64 GetCheckedSize() const;
+
+    /// Gets the position in GetContents() of a content row, or nullopt for group rows.
+    std::optional<std::size_t> GetContentIndex(const QModelIndex& index) const;
+
+    /// Gets the positions in GetContents() of the contents in a group row.
+    std::vector<std::size_t> GetGroupContents(const QModelIndex& index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = {}) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = {}) const override;
+    int columnCount(const QModelIndex& parent = {}) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value,
+                 int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+signals:
+    /// Emitted after contents have been checked or unchecked through the view.
+    void ContentsCheckStateChanged(const std::vector<std::size_t>& content_indices, bool checked);
+
+private:
+    struct Group {
+        enum class Type {
+            Ungrouped,    ///< Title View only. Contents not belonging to any application.
+            DisplayGroup, ///< All groups in Group View, and the special groups in Title View.
+            Title,        ///< Title View only. An application and its related contents.
+        };
+
+        Type type;
+        DisplayGroup display_group{}; ///< Valid for Type::DisplayGroup.
+        std::size_t application{};    ///< Valid for Type::Title. Position of the application.
+
+        std::vector<std::size_t> children;
+        std::size_t checked_count = 0;
+        std::size_t exists_count = 0;
+        u64 total_size = 0;
+    };
+
+    void CreateFixedGroups();
+    void AddTitleGroup(std::size_t application);
+    /// Records an application for grouping. Returns false if it is not a new application.
+    bool RegisterApplication(std::size_t content_index);
+    /// Gets the application a Savegame or Extdata belongs to, or nullptr.
+    const Core::ContentSpecifier* FindApplication(const Core::ContentSpecifier& specifier) const;
+    std::size_t FindGroup(std::size_t content_index) const;
+    void AddToGroup(std::size_t group_row, std::size_t content_index);
+
+    QVariant GroupData(const QModelIndex& index, int role) const;
+    QVariant ContentData(const QModelIndex& index, int role) const;
+    QString ContentDisplayName(const Group& group, std::size_t content_index) const;
+    QIcon ContentDisplayIcon(std::size_t content_index) const;
+
+    /// Gets the icon of a content, from the IconAtlas if possible.
+    QIcon ContentIcon(const Core::ContentSpecifier& specifier) const;
+    QIcon DisplayGroupIcon(DisplayGroup group) const;
+    QIcon ThemeIcon(const QString& name) const;
+
+    void SetContentsChecked(std::size_t group_row, const std::vector<std::size_t>& content_indices,
+                            bool checked);
+
+    bool title_view;
+    const Core::IconAtlas* icon_atlas = nullptr;
+
+    std::vector<Core::ContentSpecifier> contents;
+    std::vector<bool> content_checked;
+    std::vector<std::size_t> content_rows;   ///< Content -> row within its group
+    u64 checked_size = 0;
+
+    std::vector<Group> groups;
+
+    std::unordered_map<u64, std::size_t> applications; ///< Title ID -> position of application
+    std::unordered_map<u64, u64> extdata_titles;       ///< Extdata ID -> title ID
+    std::unordered_map<u64, std::size_t> title_groups; ///< Title ID -> group row (Title View)
+
+    mutable std::unordered_map<u32, QIcon> atlas_icons; ///< Icon ID -> decoded icon
+    mutable QHash<QString, QIcon> theme_icons;
+};
+
+/**
+ * Proxy of ContentListModel for sorting and for hiding contents that do not match a filter.
+ * Groups are hidden when none of their contents are visible.
+ */
+class ContentListFilterModel final : public QSortFilterProxyModel {
+    Q_OBJECT
+
+public:
+    explicit ContentListFilterModel(QObject* parent, ContentListModel* source);
+    ~ContentListFilterModel() override;
+
+    /// Shows only the given contents (positions in GetContents()), or all if nullopt.
+    void SetVisibleContents(const std::optional<std::vector<std::size_t>>& content_indices);
+
+protected:
+    bool filterAcceptsRow(int source_row, const QModelIndex& source_parent) const override;
+
+private:
+    bool IsContentVisible(std::size_t content_index) const;
+
+    ContentListModel* source;
+    bool is_filtered = false;
+    std::vector<bool> visible;
+};
@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <chrono>
+#include <future>
+#include "common/buffer_pool.h"
 #include "common/logging/log.h"
+#include "common/memory_budget.h"
 #include "frontend/helpers/multi_job.h"
 
 MultiJob::MultiJob(QObject* parent, Core::SDMCImporter& importer_,
@@ -40,21 +43,46 @@ void MultiJob::run() {
         emit ProgressUpdated(current_imported_size, total_imported_size, eta);
     };
 
+    // While a content is processed, the next one is read ahead on a background thread, so that
+    // each content does not start with cold reads.
+    std::future<void> prefetch;
+    const auto Prefetch = [this](std::size_t index) {
+        importer.PrefetchContent(contents[index], PrefetchSize, cancelled);
+    };
+
+    auto& memory_budget = Common::MemoryBudget::Get();
+    memory_budget.ResetPeakUsage();
+
     Common::ProgressCallbackWrapper wrapper{total_size};
     for (const auto& content : contents) {
         emit NextContent(count + 1, wrapper.current_done_size + wrapper.current_pending_size,
                          content, eta);
+        if (count + 1 < contents.size()) {
+            prefetch = std::async(std::launch::async, Prefetch, count + 1);
+        }
         if (!execute_func(importer, content, wrapper.Wrap(Callback))) {
             if (!cancelled) {
                 failed_contents.emplace_back(content, Common::Logging::GetLastErrors());
             }
         }
+        if (auto corrupt_data = importer.TakeCorruptData(); !corrupt_data.empty()) {
+            corrupt_contents.emplace_back(content, std::move(corrupt_data));
+        }
         count++;
 
         if (cancelled) {
             break;
         }
     }
+    if (prefetch.valid()) {
+        prefetch.wait();
+    }
+    LOG_INFO(Frontend, "Peak memory reserved for in-memory operations: {} KB",
+             memory_budget.GetPeakUsage() / 1024);
+
+    const auto pool_stats = Common::BufferPool::Get().GetStats();
+    LOG_INFO(Frontend, "Buffer pool: {} buffers requested in total, {} allocated from the system",
+             pool_stats.requests, pool_stats.system_allocations);
     emit Completed();
 }
 
@@ -66,3 +94,7 @@ void MultiJob::Cancel() {
 MultiJob::FailedContentList MultiJob::GetFailedContents() const {
     return failed_contents;
 }
+
+MultiJob::CorruptContentList MultiJob::GetCorruptContents() const {
+    return corrupt_contents;
+}
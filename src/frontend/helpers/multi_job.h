@@ -19,6 +19,9 @@ public:
     using AbortFunc = std::function<void(Core::SDMCImporter&)>;
     // (content, error log)
     using FailedContentList = std::vector<std::pair<Core::ContentSpecifier, std::string>>;
+    // (content, files with corrupt blocks), for savegames and extdata imported with verification
+    using CorruptContentList =
+        std::vector<std::pair<Core::ContentSpecifier, std::vector<Core::CorruptFile>>>;
 
     explicit MultiJob(QObject* parent, Core::SDMCImporter& importer,
                       std::vector<Core::ContentSpecifier> contents, ExecuteFunc execute_func,
@@ -29,6 +32,7 @@ public:
     void Cancel();
 
     FailedContentList GetFailedContents() const;
+    CorruptContentList GetCorruptContents() const;
 
 signals:
     /**
@@ -47,10 +51,14 @@ signals:
     void Completed();
 
 private:
+    /// Number of bytes read ahead from the next content.
+    static constexpr u64 PrefetchSize = 32 * 1024 * 1024;
+
     std::atomic_bool cancelled{false};
     Core::SDMCImporter& importer;
     std::vector<Core::ContentSpecifier> contents;
     FailedContentList failed_contents;
+    CorruptContentList corrupt_contents;
     ExecuteFunc execute_func;
     AbortFunc abort_func;
 };
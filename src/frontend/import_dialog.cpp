@@ -3,12 +3,11 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
-#include <array>
 #include <cmath>
 #include <numeric>
-#include <unordered_map>
 #include <QFileDialog>
 #include <QFutureWatcher>
+#include <QInputDialog>
 #include <QMenu>
 #include <QMessageBox>
 #include <QMouseEvent>
@@ -17,8 +16,11 @@
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/progress_callback.h"
+#include "common/memory_budget.h"
+#include "common/resource_governor.h"
 #include "common/scope_exit.h"
 #include "frontend/cia_build_dialog.h"
+#include "frontend/content_list_model.h"
 #include "frontend/helpers/frontend_common.h"
 #include "frontend/helpers/multi_job.h"
 #include "frontend/helpers/rate_limited_progress_dialog.h"
@@ -27,139 +29,25 @@
 #include "frontend/title_info_dialog.h"
 #include "ui_import_dialog.h"
 
-// Groups that are used in the frontend. This is organized in a slightly different way than Core.
-enum class DisplayGroup {
-    Application,
-    Update,
-    DLC,
-    Savegame,
-    Extdata,
-    Sysdata,
-    SystemTitle,
-    SystemApplet,
-};
-
-// clang-format off
-// group, singular name, plural name, icon name
-constexpr std::array<std::tuple<DisplayGroup, const char*, const char*, const char*>, 8>
-    DisplayGroupMap{{
-        {DisplayGroup::Application, QT_TR_NOOP("Application"), QT_TR_NOOP("Applications"), "app"},
-        {DisplayGroup::Update, QT_TR_NOOP("Update"), QT_TR_NOOP("Updates"), "update"},
-        {DisplayGroup::DLC, QT_TR_NOOP("DLC"), QT_TR_NOOP("DLCs"), "dlc"},
-        {DisplayGroup::Savegame, QT_TR_NOOP("Save Data"), QT_TR_NOOP("Save Data"), "save_data"},
-        {DisplayGroup::Extdata, QT_TR_NOOP("Extra Data"), QT_TR_NOOP("Extra Data"), "save_data"},
-        {DisplayGroup::Sysdata, QT_TR_NOOP("System Data"), QT_TR_NOOP("System Data"), "system_data"},
-        {DisplayGroup::SystemTitle, QT_TR_NOOP("System Title"), QT_TR_NOOP("System Titles"), "hos"},
-        {DisplayGroup::SystemApplet, QT_TR_NOOP("System Applet"), QT_TR_NOOP("System Applets"), "hos"},
-    }};
-// clang-format on
-
-static DisplayGroup GetDisplayGroup(const Core::ContentSpecifier& specifier) {
-    if (specifier.type == Core::ContentType::Title) {
-        switch (specifier.id >> 32) {
-        case 0x00040000:
-            return DisplayGroup::Application;
-        case 0x0004000e:
-            return DisplayGroup::Update;
-        case 0x0004008c:
-            return DisplayGroup::DLC;
-        default:
-            UNREACHABLE();
-        }
-    }
-    if (specifier.type == Core::ContentType::Savegame) {
-        return DisplayGroup::Savegame;
-    }
-    if (specifier.type == Core::ContentType::Extdata) {
-        return DisplayGroup::Extdata;
-    }
-    if (specifier.type == Core::ContentType::NandSavegame ||
-        specifier.type == Core::ContentType::NandExtdata ||
-        specifier.type == Core::ContentType::Sysdata) { // These are grouped together
-
-        return DisplayGroup::Sysdata;
-    }
-    if (specifier.type == Core::ContentType::NandTitle) {
-        return (specifier.id >> 32) == 0x00040030 ? DisplayGroup::SystemApplet
-                                                  : DisplayGroup::SystemTitle;
-    }
-    UNREACHABLE();
-}
-
-static QString GetContentName(const Core::ContentSpecifier& specifier) {
-    if (specifier.type == Core::ContentType::NandSavegame) {
-        return QObject::tr("System Save 0x%1", "ImportDialog")
-            .arg(specifier.id, 16, 16, QLatin1Char('0'));
-    }
-    if (specifier.type == Core::ContentType::NandExtdata) {
-        return QObject::tr("System Extra 0x%1", "ImportDialog")
-            .arg(specifier.id, 16, 16, QLatin1Char('0'));
-    }
-    return specifier.name.empty()
-               ? QStringLiteral("0x%1").arg(specifier.id, 16, 16, QLatin1Char('0'))
-               : QString::fromStdString(specifier.name);
-}
-
-template <bool Plural = true>
-static QString GetDisplayGroupName(DisplayGroup group) {
-    if constexpr (Plural) {
-        return QObject::tr(std::get<2>(DisplayGroupMap.at(static_cast<std::size_t>(group))),
-                           "ImportDialog");
-    } else {
-        return QObject::tr(std::get<1>(DisplayGroupMap.at(static_cast<std::size_t>(group))),
-                           "ImportDialog");
-    }
-}
-
-template <bool Plural = true>
-static QString GetDisplayGroupName(const Core::ContentSpecifier& specifier) {
-    return GetDisplayGroupName<Plural>(GetDisplayGroup(specifier));
-}
-
-static QPixmap GetDisplayGroupIcon(DisplayGroup group) {
-    return QIcon::fromTheme(
-               QString::fromUtf8(std::get<3>(DisplayGroupMap.at(static_cast<std::size_t>(group)))))
-        .pixmap(24);
-}
-
-static QPixmap GetContentIcon(const Core::ContentSpecifier& specifier) {
-    if (!specifier.icon.empty()) {
-        return QPixmap::fromImage(QImage(reinterpret_cast<const uchar*>(specifier.icon.data()), 24,
-                                         24, QImage::Format::Format_RGB16));
-    }
-
-    // Use a category icon to distinguish between different types of System Data
-    if (specifier.type == Core::ContentType::NandSavegame ||
-        specifier.type == Core::ContentType::NandExtdata) {
-        return GetDisplayGroupIcon(DisplayGroup::Savegame);
-    }
-    if (specifier.type == Core::ContentType::Sysdata) {
-        return GetDisplayGroupIcon(DisplayGroup::Sysdata);
-    }
-
-    // Use a special icon for NAND non-executable archives
-    if (specifier.type == Core::ContentType::NandTitle) {
-        const auto id_high = specifier.id >> 32;
-        if (id_high == 0x0004001b || id_high == 0x0004009b || id_high == 0x000400db) {
-            return QIcon::fromTheme(QStringLiteral("system_archive")).pixmap(24);
-        }
-    }
-
-    // Return a null icon otherwise
-    return QIcon::fromTheme(QStringLiteral("unknown")).pixmap(24);
-}
-
 ImportDialog::ImportDialog(QWidget* parent, const Core::Config& config_)
     : DPIAwareDialog(parent, 560, 320), ui(std::make_unique<Ui::ImportDialog>()), config(config_) {
 
     qRegisterMetaType<u64>("u64");
     qRegisterMetaType<std::size_t>("std::size_t");
     qRegisterMetaType<Core::ContentSpecifier>();
+    qRegisterMetaType<std::vector<Core::ContentSpecifier>>();
 
     ui->setupUi(this);
 
+    model = new ContentListModel(this, /*title_view*/ true);
+    proxy_model = new ContentListFilterModel(this, model);
+    ui->main->setModel(proxy_model);
+
+    connect(this, &ImportDialog::ContentsListed, model, &ContentListModel::AppendContents);
+    connect(model, &ContentListModel::ContentsCheckStateChanged, this,
+            &ImportDialog::OnContentsCheckStateChanged);
+
     RelistContent();
-    UpdateSizeDisplay();
 
     ui->title_view_button->setChecked(true);
 
@@ -174,15 +62,31 @@ ImportDialog::ImportDialog(QWidget* parent, const Core::Config& config_)
         }
     });
 
-    connect(ui->title_view_button, &QRadioButton::toggled, this, &ImportDialog::RepopulateContent);
+    connect(ui->title_view_button, &QRadioButton::toggled, model, &ContentListModel::SetTitleView);
     connect(ui->advanced_button, &QPushButton::clicked, this, &ImportDialog::ShowAdvancedMenu);
+    connect(ui->filter, &QLineEdit::textChanged, this, &ImportDialog::UpdateFilter);
 
+    ui->main->setSortingEnabled(true);
     ui->main->sortByColumn(-1, Qt::AscendingOrder); // disable sorting by default
     ui->main->header()->setStretchLastSection(false);
-    connect(ui->main, &QTreeWidget::customContextMenuRequested, this, &ImportDialog::OnContextMenu);
+    connect(ui->main, &QTreeView::customContextMenuRequested, this, &ImportDialog::OnContextMenu);
 }
 
-ImportDialog::~ImportDialog() = default;
+ImportDialog::~ImportDialog() {
+    list_cancelled = true;
+    init_future.waitForFinished();
+    list_future.waitForFinished();
+}
+
+void ImportDialog::reject() {
+    // Stop listing first, as the listing thread uses the importer and this dialog
+    if (is_listing) {
+        list_cancelled = true;
+        init_future.waitForFinished();
+        list_future.waitForFinished();
+    }
+    DPIAwareDialog::reject();
+}
 
 void ImportDialog::SetContentSizes(int previous_width, [[maybe_unused]] int previous_height) {
     const int current_width = width();
@@ -202,13 +106,28 @@ void ImportDialog::RelistContent() {
         new RateLimitedProgressDialog(tr("Loading Contents..."), tr("Cancel"), 0, 0, this);
     dialog->setCancelButton(nullptr);
 
+    is_listing = true;
+    list_cancelled = false;
+    ui->buttonBox->button(QDialogButtonBox::StandardButton::Reset)->setEnabled(false);
+    ui->advanced_button->setEnabled(false);
+    ui->filter->setEnabled(false);
+    filter_index.reset();
+    proxy_model->SetVisibleContents(std::nullopt);
+    model->Clear(nullptr);
+    UpdateSizeDisplay();
+
+    // The importer is initialized first. Contents are then listed in the background and shown
+    // as soon as they are found.
     using FutureWatcher = QFutureWatcher<void>;
     auto* future_watcher = new FutureWatcher(this);
-    connect(future_watcher, &FutureWatcher::finished, this, [this, dialog] {
+    connect(future_watcher, &FutureWatcher::finished, this, [this, dialog, future_watcher] {
         dialog->hide();
-        if (importer->IsGood()) {
-            RepopulateContent();
-        } else {
+        future_watcher->deleteLater();
+        if (list_cancelled) {
+            return;
+        }
+
+        if (!importer->IsGood()) {
             QMessageBox message_box(
                 QMessageBox::Critical, tr("Importer Error"),
                 tr("Failed to initalize the importer. Refer to the log for details."),
@@ -216,160 +135,102 @@ void ImportDialog::RelistContent() {
             message_box.setDetailedText(QString::fromStdString(Common::Logging::GetLastErrors()));
             message_box.exec();
             reject();
+            return;
         }
-    });
 
-    auto future = QtConcurrent::run(
-        [&importer = this->importer, &config = this->config, &contents = this->contents] {
-            if (!importer) {
-                importer = std::make_unique<Core::SDMCImporter>(config);
-            }
-            if (importer->IsGood()) {
-                contents = importer->ListContent();
+        model->Clear(&importer->GetIconAtlas());
+
+        auto* list_watcher = new FutureWatcher(this);
+        connect(list_watcher, &FutureWatcher::finished, this, [this, list_watcher] {
+            list_watcher->deleteLater();
+            if (!list_cancelled) {
+                OnListingFinished();
             }
         });
-    future_watcher->setFuture(future);
-}
-
-constexpr Qt::ItemDataRole SpecifierIndexRole = Qt::UserRole;
-
-/// Supports readable size display and sorting
-class ContentListItem final : public QTreeWidgetItem {
-public:
-    explicit ContentListItem(QString name, u64 content_size_, QString exists)
-        : QTreeWidgetItem{{std::move(name), ReadableByteSize(content_size_), std::move(exists)}},
-          content_size(content_size_) {}
-
-    explicit ContentListItem(QString name, u64 content_size_, QString exists, std::size_t idx)
-        : QTreeWidgetItem{{std::move(name), ReadableByteSize(content_size_), std::move(exists)}},
-          content_size(content_size_) {
-        setData(0, SpecifierIndexRole, static_cast<int>(idx));
-    }
-    ~ContentListItem() override = default;
-
-private:
-    bool operator<(const QTreeWidgetItem& other_item) const override {
-        const auto* other = dynamic_cast<const ContentListItem*>(&other_item);
-        if (!other) {
-            return false;
-        }
+        list_future = QtConcurrent::run([this] {
+            importer->ListContent(
+                [this](std::vector<Core::ContentSpecifier> batch) { emit ContentsListed(batch); },
+                list_cancelled);
+        });
+        list_watcher->setFuture(list_future);
+    });
 
-        const int column = treeWidget()->sortColumn();
-        if (column == 1) { // size
-            return content_size < other->content_size;
-        } else {
-            return text(column) < other->text(column);
+    init_future = QtConcurrent::run([&importer = this->importer, &config = this->config] {
+        if (!importer) {
+            importer = std::make_unique<Core::SDMCImporter>(config);
         }
-    }
-
-    u64 content_size;
-};
-
-void ImportDialog::InsertTopLevelItem(QString text, QPixmap icon) {
-    auto* item = new QTreeWidgetItem{{text}};
-    item->setIcon(0, QIcon(std::move(icon)));
-
-    item->setFlags(item->flags() | Qt::ItemIsAutoTristate);
-    item->setCheckState(0, Qt::Unchecked); // required to give the item a checkbox
-
-    ui->main->invisibleRootItem()->addChild(item);
-    item->setFirstColumnSpanned(true);
+    });
+    future_watcher->setFuture(init_future);
 }
 
-void ImportDialog::InsertTopLevelItem(QString text, QPixmap icon, u64 total_size, QString exists) {
-    auto* item = new ContentListItem{std::move(text), total_size, std::move(exists)};
-    item->setIcon(0, QIcon(std::move(icon)));
+void ImportDialog::OnListingFinished() {
+    is_listing = false;
+    ui->buttonBox->button(QDialogButtonBox::StandardButton::Reset)->setEnabled(true);
+    ui->advanced_button->setEnabled(true);
 
-    item->setFlags(item->flags() | Qt::ItemIsAutoTristate);
-    item->setCheckState(0, Qt::Unchecked); // required to give the item a checkbox
+    if (model->GetContents().empty()) { // why???
+        QMessageBox::warning(this, tr("threeSD"), tr("Sorry, there are no contents available."));
+        reject();
+        return;
+    }
+    UpdateSizeDisplay();
 
-    ui->main->invisibleRootItem()->addChild(item);
+    filter_index = std::make_shared<Core::ContentFilterIndex>(model->GetContents());
+    ui->filter->setEnabled(true);
+    UpdateFilter();
 }
 
-// Content types that themselves form a 'Title' like entity.
-constexpr std::array<DisplayGroup, 3> SpecialDisplayGroupList{{
-    DisplayGroup::Sysdata,
-    DisplayGroup::SystemTitle,
-    DisplayGroup::SystemApplet,
-}};
-
-void ImportDialog::InsertSecondLevelItem(std::size_t row, const Core::ContentSpecifier& content,
-                                         std::size_t id, QString replace_name,
-                                         QPixmap replace_icon) {
-    const bool use_title_view = ui->title_view_button->isChecked();
-    const auto group = GetDisplayGroup(content);
-
-    QString name;
-    if (use_title_view) {
-        if (row == 0) {
-            name = QStringLiteral("%1 (%2)")
-                       .arg(GetContentName(content))
-                       .arg(GetDisplayGroupName<false>(group));
-        } else if (row <= SpecialDisplayGroupList.size()) {
-            name = GetContentName(content);
-        } else {
-            name = GetDisplayGroupName<false>(group);
-        }
-    } else {
-        name = GetContentName(content);
+void ImportDialog::UpdateFilter() {
+    if (!filter_index) {
+        return;
     }
 
-    if (!replace_name.isEmpty()) {
-        name = replace_name;
+    const auto generation = ++filter_generation;
+    const auto filter = Core::ContentFilter::Parse(ui->filter->text().toStdString());
+    if (filter.IsEmpty()) {
+        proxy_model->SetVisibleContents(std::nullopt);
+        return;
     }
 
-    auto* item = new ContentListItem{name, content.maximum_size,
-                                     content.already_exists ? tr("Yes") : tr("No"), id};
-
-    // Set icon
-    QPixmap icon;
-    if (replace_icon.isNull()) {
-        const bool in_special_group =
-            std::find(SpecialDisplayGroupList.begin(), SpecialDisplayGroupList.end(), group) !=
-            SpecialDisplayGroupList.end();
-        if (use_title_view && !in_special_group) {
-            icon = GetDisplayGroupIcon(group);
-        } else {
-            icon = GetContentIcon(content);
+    using FutureWatcher = QFutureWatcher<std::vector<std::size_t>>;
+    auto* future_watcher = new FutureWatcher(this);
+    connect(future_watcher, &FutureWatcher::finished, this, [this, future_watcher, generation] {
+        future_watcher->deleteLater();
+        if (generation != filter_generation) { // The filter has changed in the meantime
+            return;
         }
-    } else {
-        icon = replace_icon;
-    }
-    item->setIcon(0, QIcon(icon));
-
-    // Skip System Applets, but enable everything else by default.
-    if (!content.already_exists && group != DisplayGroup::SystemApplet) {
-        item->setCheckState(0, Qt::Checked);
-        total_selected_size += content.maximum_size;
-    } else {
-        item->setCheckState(0, Qt::Unchecked);
-    }
+        proxy_model->SetVisibleContents(future_watcher->result());
+        ui->main->expandAll();
+    });
 
-    ui->main->invisibleRootItem()->child(static_cast<int>(row))->addChild(item);
+    auto future = QtConcurrent::run(
+        [index = filter_index, filter] { return index->Evaluate(filter); });
+    future_watcher->setFuture(future);
 }
 
-void ImportDialog::OnItemChanged(QTreeWidgetItem* item, int column) {
-    // Only handle second level items (with checkboxes)
-    if (column != 0 || !item->parent()) {
-        return;
-    }
-
-    const auto& specifier = SpecifierFromItem(item);
-    const auto group = GetDisplayGroup(specifier);
-    if (item->checkState(0) == Qt::Checked) {
-        if (!applet_warning_shown && !specifier.already_exists &&
-            group == DisplayGroup::SystemApplet) {
+void ImportDialog::OnContentsCheckStateChanged(const std::vector<std::size_t>& content_indices,
+                                               bool checked) {
+    const auto& contents = model->GetContents();
+    const auto HasNewContentIn = [&contents, &content_indices](auto... groups) {
+        return std::any_of(content_indices.begin(), content_indices.end(),
+                           [&contents, groups...](std::size_t index) {
+                               const auto group = GetDisplayGroup(contents[index]);
+                               return !contents[index].already_exists &&
+                                      ((group == groups) || ...);
+                           });
+    };
 
+    if (checked) {
+        if (!applet_warning_shown && HasNewContentIn(DisplayGroup::SystemApplet)) {
             QMessageBox::warning(
                 this, tr("Warning"),
                 tr("You are trying to import System Applets.\nThese are known to cause problems "
                    "with certain games.\nOnly proceed if you understand what you are doing."));
             applet_warning_shown = true;
         }
-        total_selected_size += specifier.maximum_size;
     } else {
-        if (!system_warning_shown && !specifier.already_exists &&
-            (group == DisplayGroup::Sysdata || group == DisplayGroup::SystemTitle)) {
+        if (!system_warning_shown &&
+            HasNewContentIn(DisplayGroup::Sysdata, DisplayGroup::SystemTitle)) {
 
             QMessageBox::warning(this, tr("Warning"),
                                  tr("You are de-selecting important files that may be necessary "
@@ -377,158 +238,10 @@ void ImportDialog::OnItemChanged(QTreeWidgetItem* item, int column) {
                                     "import these contents if they do not exist yet."));
             system_warning_shown = true;
         }
-        total_selected_size -= specifier.maximum_size;
     }
     UpdateSizeDisplay();
 }
 
-void ImportDialog::RepopulateContent() {
-    if (contents.empty()) { // why???
-        QMessageBox::warning(this, tr("threeSD"), tr("Sorry, there are no contents available."));
-        reject();
-        return;
-    }
-
-    total_selected_size = 0;
-    ui->main->clear();
-    ui->main->setSortingEnabled(false);
-    disconnect(ui->main, &QTreeWidget::itemChanged, this, &ImportDialog::OnItemChanged);
-
-    struct TitleMapEntry {
-        QString name;
-        QPixmap icon;
-        std::vector<const Core::ContentSpecifier*> contents;
-    };
-    std::map<u64, TitleMapEntry> title_map;
-    std::unordered_map<u64, u64> extdata_id_map; // extdata ID -> title ID
-    for (const auto& content : contents) {
-        // Applications
-        if (content.type == Core::ContentType::Title && (content.id >> 32) == 0x00040000) {
-            title_map[content.id].name = GetContentName(content);
-            title_map[content.id].icon = GetContentIcon(content);
-            extdata_id_map.emplace(content.extdata_id, content.id);
-        }
-    }
-    for (const auto& content : contents) {
-        if (content.type == Core::ContentType::Extdata) {
-            if (extdata_id_map.count(content.id)) {
-                const u64 title_id = extdata_id_map.at(content.id);
-                title_map[title_id].contents.emplace_back(&content);
-            }
-        } else if (content.type == Core::ContentType::Title ||
-                   content.type == Core::ContentType::Savegame) {
-            if (title_map.count(content.id)) {
-                title_map[content.id].contents.emplace_back(&content);
-            }
-        }
-    }
-
-    const bool use_title_view = ui->title_view_button->isChecked();
-    if (use_title_view) {
-        // Create 'Ungrouped' category.
-        InsertTopLevelItem(tr("Ungrouped"), QIcon::fromTheme(QStringLiteral("unknown")).pixmap(24));
-
-        // Create categories for special display groups.
-        for (std::size_t i = 0; i < SpecialDisplayGroupList.size(); ++i) {
-            InsertTopLevelItem(GetDisplayGroupName(SpecialDisplayGroupList[i]),
-                               GetDisplayGroupIcon(SpecialDisplayGroupList[i]));
-        }
-
-        // Applications
-        std::unordered_map<u64, u64> title_row_map;
-        for (auto& [id, entry] : title_map) {
-            // Process the application's contents
-            u64 total_size = 0;
-            bool has_exist = false, has_non_exist = false;
-            for (const auto* content : entry.contents) {
-                total_size += content->maximum_size;
-                if (content->already_exists) {
-                    has_exist = true;
-                } else {
-                    has_non_exist = true;
-                }
-            }
-
-            QString exist_text;
-            if (!has_exist) {
-                exist_text = tr("No");
-            } else if (!has_non_exist) {
-                exist_text = tr("Yes");
-            } else {
-                exist_text = tr("Part");
-            }
-
-            InsertTopLevelItem(std::move(entry.name), std::move(entry.icon), total_size,
-                               std::move(exist_text));
-            title_row_map.emplace(id, ui->main->invisibleRootItem()->childCount() - 1);
-        }
-
-        for (std::size_t i = 0; i < contents.size(); ++i) {
-            const auto& content = contents[i];
-
-            std::size_t row = 0; // 0 for ungrouped (default)
-            switch (content.type) {
-            case Core::ContentType::Title:
-            case Core::ContentType::Savegame: {
-                // Fix the id
-                const auto real_id = content.id & 0xffffff00ffffffff;
-                row = title_row_map.count(real_id) ? title_row_map.at(real_id) : 0;
-                break;
-            }
-            case Core::ContentType::Extdata: {
-                if (extdata_id_map.count(content.id)) {
-                    row = title_row_map.at(extdata_id_map.at(content.id));
-                } else {
-                    row = 0; // Ungrouped
-                }
-                break;
-            }
-            default: {
-                const std::size_t idx =
-                    std::find(SpecialDisplayGroupList.begin(), SpecialDisplayGroupList.end(),
-                              GetDisplayGroup(content)) -
-                    SpecialDisplayGroupList.begin();
-                ASSERT_MSG(idx < SpecialDisplayGroupList.size(), "Display Group not handled");
-                row = idx + 1;
-                break;
-            }
-            }
-
-            InsertSecondLevelItem(row, content, i);
-        }
-    } else {
-        for (const auto& [group, singular_name, plural_name, icon_name] : DisplayGroupMap) {
-            InsertTopLevelItem(tr(plural_name), GetDisplayGroupIcon(group));
-        }
-
-        for (std::size_t i = 0; i < contents.size(); ++i) {
-            const auto& content = contents[i];
-
-            QString name{};
-            QPixmap icon{};
-            if (content.type == Core::ContentType::Savegame) {
-                if (title_map.count(content.id)) {
-                    name = title_map.at(content.id).name;
-                    icon = title_map.at(content.id).icon;
-                }
-            } else if (content.type == Core::ContentType::Extdata) {
-                if (extdata_id_map.count(content.id)) {
-                    u64 title_id = extdata_id_map.at(content.id);
-                    name = title_map.at(title_id).name;
-                    icon = title_map.at(title_id).icon;
-                }
-            }
-
-            InsertSecondLevelItem(static_cast<std::size_t>(GetDisplayGroup(content)), content, i,
-                                  name, icon);
-        }
-    }
-
-    ui->main->setSortingEnabled(true);
-    connect(ui->main, &QTreeWidget::itemChanged, this, &ImportDialog::OnItemChanged);
-    UpdateSizeDisplay();
-}
-
 void ImportDialog::UpdateSizeDisplay() {
     QStorageInfo storage(QString::fromStdString(config.user_path));
     if (!storage.isValid() || !storage.isReady()) {
@@ -542,43 +255,34 @@ void ImportDialog::UpdateSizeDisplay() {
 
     ui->availableSpace->setText(
         tr("Available Space: %1").arg(ReadableByteSize(storage.bytesAvailable())));
+    const u64 total_selected_size = model->GetCheckedSize();
     ui->totalSize->setText(tr("Total Size: %1").arg(ReadableByteSize(total_selected_size)));
 
     ui->buttonBox->button(QDialogButtonBox::StandardButton::Ok)
-        ->setEnabled(total_selected_size > 0 &&
+        ->setEnabled(!is_listing && total_selected_size > 0 &&
                      total_selected_size <= static_cast<u64>(storage.bytesAvailable()));
 }
 
 std::vector<Core::ContentSpecifier> ImportDialog::GetSelectedContentList() {
-    std::vector<Core::ContentSpecifier> to_import;
-    for (int i = 0; i < ui->main->invisibleRootItem()->childCount(); ++i) {
-        const auto* item = ui->main->invisibleRootItem()->child(i);
-        for (int j = 0; j < item->childCount(); ++j) {
-            if (item->child(j)->checkState(0) == Qt::Checked) {
-                to_import.emplace_back(
-                    contents[item->child(j)->data(0, SpecifierIndexRole).toInt()]);
-            }
-        }
-    }
-
-    return to_import;
-}
-
-Core::ContentSpecifier ImportDialog::SpecifierFromItem(QTreeWidgetItem* item) const {
-    return contents[item->data(0, SpecifierIndexRole).toInt()];
+    return model->GetCheckedContents();
 }
 
 void ImportDialog::OnContextMenu(const QPoint& point) {
-    QTreeWidgetItem* item = ui->main->itemAt(point.x(), point.y());
-    if (!item) {
+    if (is_listing) {
+        return;
+    }
+
+    const auto index = proxy_model->mapToSource(ui->main->indexAt(point));
+    if (!index.isValid()) {
         return;
     }
 
     const bool title_view = ui->title_view_button->isChecked();
+    const auto& contents = model->GetContents();
 
     QMenu context_menu(this);
-    if (item->parent()) { // Second level
-        const auto& specifier = SpecifierFromItem(item);
+    if (const auto content_index = model->GetContentIndex(index)) { // Second level
+        const auto& specifier = contents[*content_index];
         const auto group = GetDisplayGroup(specifier);
         if (group == DisplayGroup::Application) {
             context_menu.addAction(tr("Dump CXI file"),
@@ -597,8 +301,8 @@ void ImportDialog::OnContextMenu(const QPoint& point) {
             return;
         }
 
-        for (int i = 0; i < item->childCount(); ++i) {
-            const auto& specifier = SpecifierFromItem(item->child(i));
+        for (const std::size_t child : model->GetGroupContents(index)) {
+            const auto& specifier = contents[child];
             const auto group = GetDisplayGroup(specifier);
             if (group == DisplayGroup::Application) {
                 context_menu.addAction(tr("Dump Base CXI file"),
@@ -617,6 +321,61 @@ void ImportDialog::OnContextMenu(const QPoint& point) {
     context_menu.exec(ui->main->viewport()->mapToGlobal(point));
 }
 
+// Adds actions to adjust the ResourceGovernor to a menu or a widget. They take effect
+// immediately, including on running jobs.
+static void AddResourceLimitActions(QWidget* target) {
+    auto* rate_action = new QAction(ImportDialog::tr("Limit I/O Rate..."), target);
+    QObject::connect(rate_action, &QAction::triggered, target, [target] {
+        auto& governor = Common::ResourceGovernor::Get();
+        bool ok{};
+        const int rate = QInputDialog::getInt(
+            target, ImportDialog::tr("Limit I/O Rate"),
+            ImportDialog::tr("Maximum I/O rate in MB/s (0 for unlimited):"),
+            static_cast<int>(governor.GetRateLimit() / 1024 / 1024), 0, 100000, 1, &ok);
+        if (ok) {
+            governor.SetRateLimit(static_cast<u64>(rate) * 1024 * 1024);
+        }
+    });
+    target->addAction(rate_action);
+
+    auto* threads_action = new QAction(ImportDialog::tr("Limit Worker Threads..."), target);
+    QObject::connect(threads_action, &QAction::triggered, target, [target] {
+        auto& governor = Common::ResourceGovernor::Get();
+        bool ok{};
+        const int threads = QInputDialog::getInt(
+            target, ImportDialog::tr("Limit Worker Threads"),
+            ImportDialog::tr("Maximum number of threads for parallel work (0 for all cores):"),
+            static_cast<int>(governor.GetMaxThreads()), 0, 1024, 1, &ok);
+        if (ok) {
+            governor.SetMaxThreads(static_cast<std::size_t>(threads));
+        }
+    });
+    target->addAction(threads_action);
+
+    auto* memory_action = new QAction(ImportDialog::tr("Limit Memory Usage..."), target);
+    QObject::connect(memory_action, &QAction::triggered, target, [target] {
+        auto& budget = Common::MemoryBudget::Get();
+        bool ok{};
+        const int limit = QInputDialog::getInt(
+            target, ImportDialog::tr("Limit Memory Usage"),
+            ImportDialog::tr("Maximum memory for files processed in memory, such as savegames "
+                             "and extdata, in MB (0 for unlimited):"),
+            static_cast<int>(budget.GetLimit() / 1024 / 1024), 0, 1024 * 1024, 1, &ok);
+        if (ok) {
+            budget.SetLimit(static_cast<u64>(limit) * 1024 * 1024);
+        }
+    });
+    target->addAction(memory_action);
+
+    auto* priority_action = new QAction(ImportDialog::tr("Run Workers at Low Priority"), target);
+    priority_action->setCheckable(true);
+    priority_action->setChecked(Common::ResourceGovernor::Get().IsLowPriority());
+    QObject::connect(priority_action, &QAction::toggled, target, [](bool checked) {
+        Common::ResourceGovernor::Get().SetLowPriority(checked);
+    });
+    target->addAction(priority_action);
+}
+
 class AdvancedMenu : public QMenu {
 public:
     explicit AdvancedMenu(QWidget* parent) : QMenu(parent) {}
@@ -644,7 +403,23 @@ void ImportDialog::ShowAdvancedMenu() {
 
     AdvancedMenu menu(this);
     menu.addAction(tr("Batch Dump CXI"), this, &ImportDialog::StartBatchDumpingCXI);
-    menu.addAction(tr("Batch Build CIA"), this, &ImportDialog::StartBatchBuildingCIA);
+    menu.addAction(tr("Batch Build CIA"), this, [this] { StartBatchBuildingCIA(false); });
+    menu.addAction(tr("Batch Archive Titles (CIA + CXI)"), this,
+                   [this] { StartBatchBuildingCIA(true); });
+    menu.addSeparator();
+    auto* verify_action = menu.addAction(tr("Verify Titles While Importing"));
+    verify_action->setCheckable(true);
+    verify_action->setChecked(verify_titles);
+    connect(verify_action, &QAction::toggled, this,
+            [this](bool checked) { verify_titles = checked; });
+    auto* verify_data_action = menu.addAction(tr("Verify Savegames and Extdata While Importing"));
+    verify_data_action->setCheckable(true);
+    verify_data_action->setChecked(verify_data);
+    connect(verify_data_action, &QAction::toggled, this,
+            [this](bool checked) { verify_data = checked; });
+    menu.addSeparator();
+
+    AddResourceLimitActions(menu.addMenu(tr("Resource Limits")));
 
     menu.exec(ui->advanced_button->mapToGlobal(ui->advanced_button->rect().bottomLeft()));
 }
@@ -673,6 +448,10 @@ void ImportDialog::RunMultiJob(MultiJob* job, std::size_t total_count, u64 total
                                                  static_cast<int>(total_size / multiplier), this);
     dialog->setLabel(label);
 
+    // Resource limits can be adjusted from the context menu while the job runs
+    AddResourceLimitActions(dialog);
+    dialog->setContextMenuPolicy(Qt::ActionsContextMenu);
+
     connect(job, &MultiJob::NextContent, this,
             [this, dialog, multiplier, total_count](std::size_t count, u64 total_imported_size,
                                                     const Core::ContentSpecifier& next_content,
@@ -685,7 +464,7 @@ void ImportDialog::RunMultiJob(MultiJob* job, std::size_t total_count, u64 total
                                    .arg(count)
                                    .arg(total_count)
                                    .arg(GetContentName(next_content))
-                                   .arg(GetDisplayGroupName<false>(next_content))
+                                   .arg(GetDisplayGroupName(next_content, false))
                                    .arg(FormatETA(eta)));
                 current_content = next_content;
                 current_count = count;
@@ -703,7 +482,7 @@ void ImportDialog::RunMultiJob(MultiJob* job, std::size_t total_count, u64 total
                     .arg(current_count)
                     .arg(total_count)
                     .arg(GetContentName(current_content))
-                    .arg(GetDisplayGroupName<false>(current_content))
+                    .arg(GetDisplayGroupName(current_content, false))
                     .arg(ReadableByteSize(current_imported_size))
                     .arg(ReadableByteSize(current_content.maximum_size))
                     .arg(FormatETA(eta)));
@@ -719,7 +498,7 @@ void ImportDialog::RunMultiJob(MultiJob* job, std::size_t total_count, u64 total
             QString details;
             for (const auto& [content, error] : failed_contents) {
                 const QString full_name = QStringLiteral("%1 (%2)").arg(
-                    GetContentName(content), GetDisplayGroupName<false>(content));
+                    GetContentName(content), GetDisplayGroupName(content, false));
 
                 list_content.append(QStringLiteral("<li>%1</li>").arg(full_name));
                 details.append(
@@ -734,6 +513,37 @@ void ImportDialog::RunMultiJob(MultiJob* job, std::size_t total_count, u64 total
             message_box.exec();
         }
 
+        const auto corrupt_contents = job->GetCorruptContents();
+        if (!corrupt_contents.empty()) {
+            QString list_content;
+            QString details;
+            for (const auto& [content, files] : corrupt_contents) {
+                const QString full_name = QStringLiteral("%1 (%2)").arg(
+                    GetContentName(content), GetDisplayGroupName(content, false));
+
+                list_content.append(QStringLiteral("<li>%1</li>").arg(full_name));
+                details.append(QStringLiteral("%1:\n").arg(full_name));
+                for (const auto& file : files) {
+                    for (const auto& range : file.ranges) {
+                        details.append(tr("%1: partition %2, IVFC level %3, 0x%4-0x%5\n")
+                                           .arg(QString::fromStdString(file.path))
+                                           .arg(static_cast<int>(range.partition))
+                                           .arg(static_cast<int>(range.level))
+                                           .arg(range.offset, 0, 16)
+                                           .arg(range.offset + range.size, 0, 16));
+                    }
+                }
+            }
+            QMessageBox message_box(
+                QMessageBox::Warning, tr("threeSD"),
+                tr("Corrupt blocks were found in these contents:<ul>%1</ul>They were imported "
+                   "anyway, as the blocks may be unused. Keep the original data if possible.")
+                    .arg(list_content),
+                QMessageBox::Ok, this);
+            message_box.setDetailedText(details);
+            message_box.exec();
+        }
+
         RelistContent();
     });
     connect(dialog, &QProgressDialog::canceled, this, [this, job] {
@@ -760,11 +570,13 @@ void ImportDialog::StartImporting() {
     auto to_import = GetSelectedContentList();
     const std::size_t total_count = to_import.size();
 
+    importer->SetVerifyTitles(verify_titles);
+    importer->SetVerifyData(verify_data);
     auto* job =
         new MultiJob(this, *importer, std::move(to_import), &Core::SDMCImporter::ImportContent,
                      &Core::SDMCImporter::AbortImporting);
 
-    RunMultiJob(job, total_count, total_selected_size);
+    RunMultiJob(job, total_count, model->GetCheckedSize());
 }
 
 // CXI dumping
@@ -860,7 +672,7 @@ void ImportDialog::StartBuildingCIASingle(const Core::ContentSpecifier& specifie
     job->StartWithProgressDialog(this);
 }
 
-void ImportDialog::StartBatchBuildingCIA() {
+void ImportDialog::StartBatchBuildingCIA(bool archive) {
     auto to_import = GetSelectedContentList();
     if (to_import.empty()) {
         QMessageBox::warning(this, tr("threeSD"),
@@ -886,15 +698,39 @@ void ImportDialog::StartBatchBuildingCIA() {
 
     to_import.erase(removed_iter, to_import.end());
 
+    // Check whether the titles can be built as legit CIAs, without blocking the UI thread
+    auto* dialog =
+        new RateLimitedProgressDialog(tr("Checking Titles..."), tr("Cancel"), 0, 0, this);
+    dialog->setCancelButton(nullptr);
+
+    using FutureWatcher = QFutureWatcher<std::vector<bool>>;
+    auto* future_watcher = new FutureWatcher(this);
+    connect(future_watcher, &FutureWatcher::finished, this,
+            [this, dialog, future_watcher, to_import, archive] {
+                dialog->hide();
+                const auto legit = future_watcher->result();
+                future_watcher->deleteLater();
+
+                const bool enable_legit =
+                    std::all_of(legit.begin(), legit.end(), [](bool value) { return value; });
+                ShowBatchBuildingCIADialog(to_import, enable_legit, archive);
+            });
+
+    auto future = QtConcurrent::run(
+        [this, to_import] { return importer->CanBuildLegitCIA(to_import); });
+    future_watcher->setFuture(future);
+}
+
+void ImportDialog::ShowBatchBuildingCIADialog(std::vector<Core::ContentSpecifier> to_import,
+                                              bool enable_legit, bool archive) {
     const bool is_nand = std::all_of(to_import.begin(), to_import.end(),
                                      [](const Core::ContentSpecifier& specifier) {
                                          return specifier.type == Core::ContentType::NandTitle;
                                      });
-    const bool enable_legit = std::all_of(to_import.begin(), to_import.end(),
-                                          [this](const Core::ContentSpecifier& specifier) {
-                                              return importer->CanBuildLegitCIA(specifier);
-                                          });
     CIABuildDialog dialog(this, /*is_dir*/ true, is_nand, enable_legit, last_batch_build_cia_path);
+    if (archive) {
+        dialog.setWindowTitle(tr("Batch Archive Titles"));
+    }
     if (dialog.exec() != QDialog::Accepted) {
         return;
     }
@@ -909,13 +745,33 @@ void ImportDialog::StartBatchBuildingCIA() {
                                             [](u64 sum, const Core::ContentSpecifier& specifier) {
                                                 return sum + specifier.maximum_size;
                                             });
-    auto* job = new MultiJob(
-        this, *importer, std::move(to_import),
-        [path = path, type = type](Core::SDMCImporter& importer,
-                                   const Core::ContentSpecifier& specifier,
-                                   const Common::ProgressCallback& callback) {
-            return importer.BuildCIA(type, specifier, path.toStdString(), callback, true);
-        },
-        &Core::SDMCImporter::AbortBuildCIA);
+    MultiJob* job;
+    if (archive) {
+        job = new MultiJob(
+            this, *importer, std::move(to_import),
+            [path = path, type = type](Core::SDMCImporter& importer,
+                                       const Core::ContentSpecifier& specifier,
+                                       const Common::ProgressCallback& callback) {
+                Core::TitleOutputs outputs;
+                outputs.verify = true;
+                outputs.cia_path = path.toStdString();
+                outputs.cia_type = type;
+                if (specifier.type == Core::ContentType::Title &&
+                    (specifier.id >> 32) == 0x00040000) { // Applications only
+                    outputs.cxi_path = outputs.cia_path;
+                }
+                return importer.ExportTitle(specifier, outputs, callback);
+            },
+            &Core::SDMCImporter::AbortExportTitle);
+    } else {
+        job = new MultiJob(
+            this, *importer, std::move(to_import),
+            [path = path, type = type](Core::SDMCImporter& importer,
+                                       const Core::ContentSpecifier& specifier,
+                                       const Common::ProgressCallback& callback) {
+                return importer.BuildCIA(type, specifier, path.toStdString(), callback, true);
+            },
+            &Core::SDMCImporter::AbortBuildCIA);
+    }
     RunMultiJob(job, total_count, total_size);
 }
@@ -4,18 +4,21 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <vector>
-#include <QPixmap>
+#include <QFuture>
+#include "core/content_filter.h"
 #include "core/file_sys/ncch_container.h"
 #include "core/importer.h"
 #include "helpers/dpi_aware_dialog.h"
 
 class AdvancedMenu;
+class ContentListFilterModel;
+class ContentListModel;
 class MultiJob;
 class SimpleJob;
-class QTreeWidgetItem;
 
 namespace Ui {
 class ImportDialog;
@@ -28,27 +31,27 @@ public:
     explicit ImportDialog(QWidget* parent, const Core::Config& config);
     ~ImportDialog() override;
 
+signals:
+    // Emitted from the listing thread for each batch of contents found.
+    void ContentsListed(const std::vector<Core::ContentSpecifier>& contents);
+
+public slots:
+    void reject() override;
+
 private:
     void SetContentSizes(int previous_width, int previous_height) override;
 
     void RelistContent();
-    void RepopulateContent();
+    void OnListingFinished();
+    void UpdateFilter();
     void UpdateSizeDisplay();
     std::vector<Core::ContentSpecifier> GetSelectedContentList();
 
-    void InsertTopLevelItem(QString text, QPixmap icon = {});
-    void InsertTopLevelItem(QString text, QPixmap icon, u64 total_size, QString exists);
-    // When replace_name and replace_icon are present they are used instead of those in `content`.
-    void InsertSecondLevelItem(std::size_t row, const Core::ContentSpecifier& content,
-                               std::size_t id, QString replace_name = {},
-                               QPixmap replace_icon = {});
-
-    Core::ContentSpecifier SpecifierFromItem(QTreeWidgetItem* item) const;
-
     void OnContextMenu(const QPoint& point);
     void ShowAdvancedMenu();
 
-    void OnItemChanged(QTreeWidgetItem* item, int column);
+    void OnContentsCheckStateChanged(const std::vector<std::size_t>& content_indices,
+                                     bool checked);
 
     void RunMultiJob(MultiJob* job, std::size_t total_count, u64 total_size);
 
@@ -61,7 +64,11 @@ private:
 
     void StartBuildingCIASingle(const Core::ContentSpecifier& content);
     QString last_build_cia_path; // Used for recording last path in StartBuildingCIASingle
-    void StartBatchBuildingCIA();
+    // When archive is set, the CXIs of Applications are dumped next to the CIAs and everything is
+    // verified, with a single pass over the contents of each title.
+    void StartBatchBuildingCIA(bool archive);
+    void ShowBatchBuildingCIADialog(std::vector<Core::ContentSpecifier> to_import,
+                                    bool enable_legit, bool archive);
     QString last_batch_build_cia_path; // Used for recording last path in StartBatchBuildingCIA
 
     std::unique_ptr<Ui::ImportDialog> ui;
@@ -69,8 +76,22 @@ private:
     std::unique_ptr<Core::SDMCImporter> importer;
     const Core::Config config;
 
-    std::vector<Core::ContentSpecifier> contents;
-    u64 total_selected_size = 0;
+    ContentListModel* model;
+    ContentListFilterModel* proxy_model;
+    bool is_listing = false;
+    // Background work using the importer, waited for before the dialog goes away
+    QFuture<void> init_future;
+    QFuture<void> list_future;
+    std::atomic_bool list_cancelled{false};
+
+    std::shared_ptr<const Core::ContentFilterIndex> filter_index;
+    // Incremented for each filter update, so that results of outdated updates can be dropped.
+    std::size_t filter_generation = 0;
+
+    // Whether titles are checked against their TMD hashes while being imported
+    bool verify_titles = false;
+    // Whether savegames and extdata are checked against their IVFC hashes while being imported
+    bool verify_data = false;
 
     // HACK: Block advanced menu trigger once.
     bool block_advanced_menu = false;
@@ -3,8 +3,13 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
 #include <regex>
 #include <string>
+#include <fmt/format.h>
 #include <QApplication>
 #include <QFileDialog>
 #include <QMessageBox>
@@ -24,6 +29,11 @@
 #include "common/common_paths.h"
 #endif
 
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
+
 #ifdef QT_STATICPLUGIN
 #include <QtPlugin>
 
@@ -246,6 +256,51 @@ void MainDialog::LaunchImportDialog() {
     dialog.exec();
 }
 
+/**
+ * Command line mode: threeSD --stream-cia <SD card mount point> <title ID> [pirate]
+ * Builds a Legit (or PirateLegit) CIA of a title and writes it to stdout, so that it can be piped
+ * into a compressor or archiver without a temporary file.
+ */
+static int StreamCIAToStdout(int argc, char* argv[]) {
+    if (argc < 4) {
+        fmt::print(stderr, "Usage: {} --stream-cia <SD card mount point> <title ID> [pirate]\n",
+                   argv[0]);
+        return 1;
+    }
+
+    const auto configs = Core::LoadPresetConfig(argv[2]);
+    if (configs.empty() || !IsConfigGood(configs[0])) {
+        LOG_ERROR(Frontend, "Could not load configuration from {}", argv[2]);
+        return 1;
+    }
+    Core::SDMCImporter importer(configs[0]);
+    if (!importer.IsGood()) {
+        LOG_ERROR(Frontend, "Failed to initialize importer");
+        return 1;
+    }
+
+    const u64 title_id = std::strtoull(argv[3], nullptr, 16);
+    const auto contents = importer.ListContent();
+    const auto iter = std::find_if(contents.begin(), contents.end(),
+                                   [title_id](const Core::ContentSpecifier& specifier) {
+                                       return Core::IsTitle(specifier.type) &&
+                                              specifier.id == title_id;
+                                   });
+    if (iter == contents.end()) {
+        LOG_ERROR(Frontend, "Title {:016x} not found", title_id);
+        return 1;
+    }
+
+    const auto build_type = argc >= 5 && std::strcmp(argv[4], "pirate") == 0
+                                ? Core::CIABuildType::PirateLegit
+                                : Core::CIABuildType::Legit;
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    auto destination = std::make_shared<FileUtil::IOFile>(stdout);
+    return importer.StreamCIA(build_type, *iter, std::move(destination), [](u64, u64) {}) ? 0 : 1;
+}
+
 int main(int argc, char* argv[]) {
     // Init settings params
     QCoreApplication::setOrganizationName(QStringLiteral("zhaowenlan1779"));
@@ -253,6 +308,10 @@ int main(int argc, char* argv[]) {
 
     Common::Logging::InitializeLogging();
 
+    if (argc >= 2 && std::strcmp(argv[1], "--stream-cia") == 0) {
+        return StreamCIAToStdout(argc, argv);
+    }
+
 #ifdef __APPLE__
     std::string bin_path = FileUtil::GetBundleDirectory() + DIR_SEP + "..";
     chdir(bin_path.c_str());
@@ -99,17 +99,17 @@ void TitleInfoDialog::LoadEncryption(Core::NCCHContainer& ncch) {
 }
 
 void TitleInfoDialog::LoadIcons() {
-    ui->iconLargeLabel->setPixmap(
-        QPixmap::fromImage(QImage(reinterpret_cast<const uchar*>(smdh.GetIcon(true).data()), 48, 48,
-                                  QImage::Format::Format_RGB16)));
+    const auto large_icon = smdh.GetIconARGB8888(true);
+    ui->iconLargeLabel->setPixmap(QPixmap::fromImage(QImage(
+        reinterpret_cast<const uchar*>(large_icon.data()), 48, 48, QImage::Format::Format_RGB32)));
 
     QAction* save_icon_large = new QAction(tr("Save Icon (Large)"), this);
     ui->iconLargeLabel->addAction(save_icon_large);
     connect(save_icon_large, &QAction::triggered, this, [this] { SaveIcon(true); });
 
-    ui->iconSmallLabel->setPixmap(
-        QPixmap::fromImage(QImage(reinterpret_cast<const uchar*>(smdh.GetIcon(false).data()), 24,
-                                  24, QImage::Format::Format_RGB16)));
+    const auto small_icon = smdh.GetIconARGB8888(false);
+    ui->iconSmallLabel->setPixmap(QPixmap::fromImage(QImage(
+        reinterpret_cast<const uchar*>(small_icon.data()), 24, 24, QImage::Format::Format_RGB32)));
 
     QAction* save_icon_small = new QAction(tr("Save Icon (Small)"), this);
     ui->iconSmallLabel->addAction(save_icon_small);
@@ -192,6 +192,7 @@ void TitleInfoDialog::UpdateNames() {
 }
 
 void TitleInfoDialog::InitializeChecks(Core::TitleMetadata& tmd) {
+    importer.WaitForBackgroundDBs(); // Certs are needed for signature checks
     const bool tmd_legit = tmd.ValidateSignature() && tmd.VerifyHashes();
     if (tmd_legit) {
         ui->tmdCheckLabel->setText(tr("Legit"));
@@ -199,10 +200,9 @@ void TitleInfoDialog::InitializeChecks(Core::TitleMetadata& tmd) {
         ui->tmdCheckLabel->setText(tr("Illegit"));
     }
 
-    if (const auto& ticket_db = importer.GetTicketDB();
-        ticket_db && ticket_db->tickets.count(specifier.id)) {
-
-        const bool ticket_legit = ticket_db->tickets.at(specifier.id).ValidateSignature();
+    const auto& ticket_db = importer.GetTicketDB();
+    if (Core::Ticket ticket; ticket_db && ticket_db->GetTicket(specifier.id, ticket)) {
+        const bool ticket_legit = ticket.ValidateSignature();
         if (ticket_legit) {
             ui->ticketCheckLabel->setText(tr("Legit"));
         } else {
@@ -190,7 +190,7 @@ void UtilitiesDialog::SaveDataExtractionTool() {
         ShowProgressDialog([sdmc_root = sdmc_root, relative_source = relative_source,
                             source = source, destination = destination] {
             Core::SDMCFile file(sdmc_root, relative_source, "rb");
-            Core::Savegame save(file.GetData());
+            Core::Savegame save(file.GetData<Common::PooledBuffer>());
             if (!save.IsGood()) {
                 return false;
             }
@@ -201,7 +201,7 @@ void UtilitiesDialog::SaveDataExtractionTool() {
         // TODO: Add Progress reporting
         ShowProgressDialog([source = source, destination = destination] {
             FileUtil::IOFile file(source.toStdString(), "rb");
-            Core::Savegame save(file.GetData());
+            Core::Savegame save(file.GetData<Common::PooledBuffer>());
             if (!save.IsGood()) {
                 return false;
             }